@@ -20,20 +20,28 @@
  */
 
 
+// needed for getline, fileno and ftruncate
+#define _POSIX_C_SOURCE 200809L
+
 // needed to retrieve the number of cpu cores
 #ifdef _WIN32
 	#define WIN32_LEAN_AND_MEAN
 	#include <windows.h>
 #else
 	#include <unistd.h>
+	#include <sys/mman.h>		// needed for the memory mapped graphml reader
+	#include <signal.h>			// needed to stop decompressing early
 #endif
 
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <math.h>
+#include <float.h>
 #include <sys/time.h>
 #include <string.h>
+#include <errno.h>
 #include <stdatomic.h>
 #include <pthread.h>
 #include <inttypes.h>
@@ -43,6 +51,8 @@
 #include <gsl/gsl_randist.h>
 #include <gsl/gsl_sf_gamma.h>
 #include <expat.h>
+#include <zlib.h>
+#include <zstd.h>
 #include <mpfr.h>
 
 
@@ -57,6 +67,9 @@
  * INT: the data type that needs to be able to store the NUMBER of vertices
  * INTD: the data type that needs to be able to store the sum of distances
  *	   from a single vertex to the rest
+ * INTW: the data type that needs to be able to store the sum of distances
+ *	   over all pairs of vertices (printf has no format for it, see
+ *	   obputu128)
  */
 
 #define DOUBLE long double
@@ -68,6 +81,8 @@
 #define INTD unsigned long long
 #define FINTD llu
 
+#define INTW unsigned __int128
+
 #define PREC 1024
 
 /* in order to use the format strings we need some macros 
@@ -89,6 +104,13 @@
 /*######### graph data structures and algorithms #######*/
 
 
+/*
+ * large output buffers and fast conversion of numbers to text, used by
+ * print_graphml() and the output functions
+ */
+#include "io/obuf.h"
+
+
 /*
  * provides a data structure that holds a graph
 */
@@ -102,6 +124,39 @@
 #include "graph/bfscentrality.h"
 
 
+/*
+ * linear time algorithms for the betweenness centrality and eccentricity 
+ * of the vertices of a tree
+ */
+#include "graph/treecentrality.h"
+#include "graph/treedist.h"
+
+
+/*
+ * diameter, radius and center of trees and graphs using few breadth-first 
+ * searches
+ */
+#include "graph/diameter.h"
+
+
+/*
+ * renumbers the vertices of a graph to improve cache locality of traversals
+ */
+#include "graph/reorder.h"
+
+
+/*
+ * connected components with a parallel union-find structure
+ */
+#include "graph/components.h"
+
+
+/*
+ * level-synchronous parallel breadth-first search with bottom-up steps
+ */
+#include "graph/parbfs.h"
+
+
 
 
 /*######### io-functions #######*/
@@ -115,24 +170,94 @@
 
 
 /*
- * uses a hashmap to build a graph structure out of a list of vertices
- * and edges that are given by strings and pairs of strings, respectively.
+ * container files that hold the outputs of many samples with an index
+ */
+#include "io/container.h"
+
+
+/*
+ * gzip and zstd compressed input and output files, (de-)compressed on
+ * separate threads
+ */
+#include "io/compress.h"
+
+
+/*
+ * interns vertex identifiers in a hash table and builds a graph structure
+ * out of vertices and edges that are given by strings and pairs of strings,
+ * respectively.
  */
 #include "io/strtograph.h"
 
 
+/*
+ * reads large graphml files via mmap and tokenizes them on several threads
+ */
+#include "io/graphmlmmap.h"
+
+
 /*
  * parses a graphml file using the expat XML parser library
  */
 #include "io/graphmlparse.h"
 
 
+/*
+ * compact binary graph format
+ */
+#include "io/gbin.h"
+
+
+/*
+ * succinct balanced parentheses format for trees
+ */
+#include "io/bp.h"
+
+
+/*
+ * edge lists, METIS and DIMACS graph files
+ */
+#include "io/textgraph.h"
+
+
+/*
+ * sequences as NumPy arrays
+ */
+#include "io/npy.h"
+
+
 /*
  * output functions for graphs (graphml format) and sequences of data
  */
 #include "io/output.h"
 
 
+/*
+ * Lukasiewicz path, height and contour process decimated to a given number
+ * of buckets
+ */
+#include "io/paths.h"
+
+
+/*
+ * writes the outputs of a sample on a separate thread while the next
+ * sample is simulated
+ */
+#include "io/writequeue.h"
+
+
+/*
+ * closeness centrality of a range of vertices with periodic checkpoints
+ */
+#include "io/checkpoint.h"
+
+
+/*
+ * merge partial sequence files
+ */
+#include "io/merge.h"
+
+
 /*
  * read a previously simulted graph from input
  */
@@ -171,8 +296,9 @@ int main(int argc, char *argv[]) {
 
 	/* tests routines for header functions
 		unit_test_graph();
+		i = unit_test_looptree() + unit_test_parbfs() + unit_test_gbin() + unit_test_bp();
 	
-		return 0;
+		return (i > 0) ? -1 : 0;
 	*/
 
 	/* read command line options and perform some sanity checks*/
@@ -180,6 +306,11 @@ int main(int argc, char *argv[]) {
 		fprintf(stderr, "Error reading command line options.\n");
 		exit(-1);
 	}
+	outthreads = comarg.threads;
+
+	/* collect the outputs of all samples in container files */
+	if(comarg.Tcontainer && comarg.method != 4)
+		setcontainers(&comarg);
 
 	/* initialize random number generators; one for each thread */
 	rgens = (gsl_rng **) calloc(comarg.threads, sizeof(gsl_rng *));
@@ -204,11 +335,25 @@ int main(int argc, char *argv[]) {
 			// read from input file instead of random generation
 			rfile(&comarg);
 			break;
+		case 3:
+			// merge partial closeness centrality files
+			mergeseq(comarg.mergefiles, comarg.nummerge, comarg.centfile);
+			break;
+		case 4:
+			// copy a record out of container files
+			for(i=0; i<comarg.nummerge; i++)
+				extractrecord(comarg.mergefiles[i], comarg.extract, stdout);
+			break;
+		case 5:
+			// read several input files on a pool of threads
+			rbatch(&comarg);
+			break;
 		default:
 			exit(-1);
 	}
 	
 	/* clean up */
+	closecontainers();
 	for(i=0; i<comarg.threads; i++)
 		gsl_rng_free(rgens[i]);
 	free(rgens);
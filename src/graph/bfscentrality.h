@@ -20,24 +20,79 @@ struct gsegment {
 	INT start;
 	INT end;
 	int success;
+	INT *ecc;		// eccentricities (optional)
+	DOUBLE *btw;	// partial betweenness centralities
+	int dohist;		// count distances?
+	INTD *hist;		// partial distance histogram
 };
 
 
+/*
+ * Breadth-first search from the vertex v that returns the sum of distances
+ * from v to all other vertices. The helper array arr must have been
+ * initialized with status -1 and mark must differ from the marks of all 
+ * previous searches that used arr. If ecc is not NULL, the eccentricity of v 
+ * is stored in *ecc. If hist is not NULL, hist[d] is increased by the number
+ * of vertices at distance d from v.
+ */
+INTD closenessbfs(struct graph *G, struct vertex *v, INT mark, struct stat *arr, struct vertex **queue, INT *ecc, INTD *hist) {
+	struct list *li;
+	INT j;
+	INT num = G->num;		// number of vertices in our graph
+	INTD dist;
+
+	INT pop;			// index for queue
+
+
+	// this is the part that needs to be as fast as possible
+	dist=0;		// this variable will denote the sum of all distances
+	queue[0] = v;				// queue the starting vertex		
+	arr[v->id].status = mark;	// mark the starting vertex as queued
+	arr[v->id].dist = 0;		// the starting vertex has distance zero
+								// from itself
+
+	// need j!= pop check for disconnected grpahs
+	for(j=0, pop=1; j<num && j!=pop; j++) {		// iterate over the entire queue
+		dist += arr[queue[j]->id].dist;	// add contribution of vertex to dist
+
+		// queue all neighbours of our vertex that have not been queued yet
+		for(li = queue[j]->qu->li; li != NULL; li = li->ne) {
+			if( arr[li->ve->id].status != mark) {	// vertex yet unqueued
+				queue[pop] = li->ve;			// queue vertex
+				pop++;	// increment index for queue location
+
+				arr[li->ve->id].status = mark;	// mark vertex as queued
+				arr[li->ve->id].dist = arr[queue[j]->id].dist + 1; //dist
+			}
+		}
+	}
+
+	// the last vertex in the queue has maximal distance
+	if(ecc != NULL) *ecc = arr[queue[j-1]->id].dist;
+
+	// count the vertices at each distance
+	if(hist != NULL) {
+		for(j=1; j<pop; j++)
+			hist[arr[queue[j]->id].dist]++;
+	}
+
+	return dist;
+}
+
+
 // calculate closeness centrality of vertices with ids start, start+1, ..., end-1
 void *centrality(void *seg) {
 	struct graph *G = ((struct gsegment *)seg)->G;
 	INT start = ((struct gsegment *)seg)->start;
 	INT end = ((struct gsegment *)seg)->end;
+	INT *ecc = ((struct gsegment *)seg)->ecc;
+	INTD *hist = NULL;
 
 	struct stat *arr;		// array that holds status information
 	struct vertex **queue;	// we realize the queue as a static array to
 							// avoid repeated memory allocation & deallocation
-	struct list *li;
-	INT i,j;
+	INT i;
 	INT num = G->num;		// number of vertices in our graph
-	INTD dist;
-
-	INT pop;			// index for queue
 
 
 
@@ -70,35 +125,22 @@ void *centrality(void *seg) {
 		arr[i].status = -1;
 	}
 
+	// every thread counts distances in its own histogram
+	if( ((struct gsegment *)seg)->dohist ) {
+		hist = (INTD *) calloc(num, sizeof(INTD));
+		if(hist == NULL) {
+			fprintf(stderr, "Memory allocation error in function centrality\n");
+			return (void *) -1;
+		}
+		((struct gsegment *)seg)->hist = hist;
+	}
+
 
 
 	// calculate closeness centrality
-	// this is the part that needs to be as fast as possible
 	for(i=start; i<end; i++) {
-
-		dist=0;		// this variable will denote the sum of all distances
-		queue[0] = G->arr[i];		// queue the starting vertex		
-		arr[i].status = i;			// mark the starting vertex as queued
-		arr[i].dist = 0;			// the starting vertex has distance zero
-									// from itself
-
-		// need j!= pop check for disconnected grpahs
-		for(j=0, pop=1; j<num && j!=pop; j++) {		// iterate over the entire queue
-			dist += arr[queue[j]->id].dist;	// add contribution of vertex to dist
-
-			// queue all neighbours of our vertex that have not been queued yet
-			for(li = queue[j]->qu->li; li != NULL; li = li->ne) {
-				if( arr[li->ve->id].status != i) {	// vertex yet unqueued
-					queue[pop] = li->ve;			// queue vertex
-					pop++;	// increment index for queue location
-
-					arr[li->ve->id].status = i;	// mark vertex as queued
-					arr[li->ve->id].dist = arr[queue[j]->id].dist + 1; //dist
-				}
-			}
-		}
-			// save distance sum of vertex
-			G->arr[i]->cent = dist;
+		// save distance sum of vertex
+		G->arr[i]->cent = closenessbfs(G, G->arr[i], i, arr, queue, (ecc != NULL) ? &ecc[i] : NULL, hist);
 	}
 
 	// free helper arrays
@@ -108,28 +150,24 @@ void *centrality(void *seg) {
 	return (void *) 0;
 }
 
-int threadedcentrality(struct graph *G, INT start, INT end, INT numThreads) {
+/*
+ * Splits the vertex ids start, start+1, ..., end-1 into numThreads segments
+ * of roughly equal size
+ */
+struct gsegment *makesegments(struct graph *G, INT start, INT end, INT numThreads) {
 	INT chunkSize;				// roughly how many vertices each thread
 								// has to take care of
 	struct gsegment *segList;	// arguments for the separate threads
-	pthread_t *th;				// array of threads
 	INT i;
-	void *ret;
 
 	INT *boxes;
 
 
-	/* sanity checks */
-	if(numThreads <= 0) return -1;
-	if(end <= start) return 0;
-	if(G->num < end) return -1;
-		   
-
 	/* divide the workload */
 	boxes = (INT *) calloc(numThreads, sizeof(INT));
 	segList = (struct gsegment *) calloc(numThreads, sizeof(struct gsegment));
 	if(boxes == NULL || segList == NULL) {
-		fprintf(stderr, "Error allocating memory in function threadedcentrality.\n");
+		fprintf(stderr, "Error allocating memory in function makesegments.\n");
 		exit(-1);
 	}
 
@@ -151,24 +189,41 @@ int threadedcentrality(struct graph *G, INT start, INT end, INT numThreads) {
 	// set segment
 	segList[0].start = start;
 	segList[0].end = boxes[0];
-	segList[0].G = G;
 	for(i=1; i<numThreads; i++) {
 		segList[i].start = boxes[i-1];
 		segList[i].end = boxes[i];
+	}
+	for(i=0; i<numThreads; i++) {
 		segList[i].G = G;
+		segList[i].ecc = NULL;
+		segList[i].btw = NULL;
+		segList[i].dohist = 0;
+		segList[i].hist = NULL;
 	}
 
 	free(boxes);
 
+	return segList;
+}
+
+
+/*
+ * Runs the function func on each of the numThreads segments in its own thread
+ */
+int runsegments(struct gsegment *segList, INT numThreads, void *(*func)(void *)) {
+	pthread_t *th;				// array of threads
+	INT i;
+	void *ret;
+
 	/* launch threads */	
 	th = calloc(sizeof(pthread_t), numThreads);
 	if(th == NULL) {
-		fprintf(stderr, "Error allocating memory in function threadedcentrality.\n");
+		fprintf(stderr, "Error allocating memory in function runsegments.\n");
 		exit(-1);
 	}
 
 	for(i=0; i<numThreads; i++) {
-		if(pthread_create(&th[i], NULL, &centrality, &segList[i] )) {
+		if(pthread_create(&th[i], NULL, func, &segList[i] )) {
 			fprintf(stderr, "Error launching thread number %"STR(FINT)"\n", i);
 			return -1;
 		}
@@ -185,9 +240,175 @@ int threadedcentrality(struct graph *G, INT start, INT end, INT numThreads) {
 	}
 
 	/* clean up */
-	free(segList);
 	free(th);	
 
 	return 0;
 }
 
+
+/*
+ * Calculates the closeness centrality of the vertices with ids
+ * start, start+1, ..., end-1 using numThreads threads
+ *
+ * If ecc is not NULL, the eccentricity of vertex i gets stored in ecc[i]
+ * If hist is not NULL, hist[d] gets increased by the number of pairs of
+ * vertices (v,w) with distance d and v among the vertices start, ..., end-1
+ * The array hist needs to have G->num entries.
+ */
+int threadedcentrality(struct graph *G, INT start, INT end, INT numThreads, INT *ecc, INTD *hist) {
+	struct gsegment *segList;	// arguments for the separate threads
+	INT i, d;
+	int ret;
+
+
+	/* sanity checks */
+	if(numThreads <= 0) return -1;
+	if(end <= start) return 0;
+	if(G->num < end) return -1;
+		   
+
+	/* divide the workload */
+	segList = makesegments(G, start, end, numThreads);
+	for(i=0; i<numThreads; i++) {
+		segList[i].ecc = ecc;
+		segList[i].dohist = (hist != NULL);
+	}
+
+	/* launch threads and wait for them to finish */
+	ret = runsegments(segList, numThreads, &centrality);
+
+	/* merge the histograms of the threads */
+	for(i=0; i<numThreads; i++) {
+		if(segList[i].hist == NULL) continue;
+		for(d=0; d<G->num; d++)
+			hist[d] += segList[i].hist[d];
+		free(segList[i].hist);
+	}
+
+	/* clean up */
+	free(segList);
+
+	return ret;
+}
+
+
+// calculate the betweenness centrality of the vertices using Brandes'
+// algorithm with the vertices start, start+1, ..., end-1 as sources
+void *betweenness(void *seg) {
+	struct graph *G = ((struct gsegment *)seg)->G;
+	INT start = ((struct gsegment *)seg)->start;
+	INT end = ((struct gsegment *)seg)->end;
+
+	DOUBLE *btw;			// partial betweenness of this thread
+	DOUBLE *sigma;			// number of shortest paths from the source
+	DOUBLE *delta;			// dependency of the source on a vertex
+	INT *dist;				// distance from the source
+	struct vertex **queue;	// bfs order, traversed backwards afterwards
+	struct list *li;
+	INT i, j, v, w;
+	INT num = G->num;		// number of vertices in our graph
+	INT pop;				// index for queue
+
+
+	btw = (DOUBLE *) calloc(num, sizeof(DOUBLE));
+	sigma = (DOUBLE *) calloc(num, sizeof(DOUBLE));
+	delta = (DOUBLE *) calloc(num, sizeof(DOUBLE));
+	dist = (INT *) calloc(num, sizeof(INT));
+	queue = (struct vertex **) calloc(num, sizeof(struct vertex *));
+	if(btw == NULL || sigma == NULL || delta == NULL || dist == NULL || queue == NULL) {
+		fprintf(stderr, "Memory allocation error in function betweenness.\n");
+		exit(-1);
+	}
+
+	// distance num marks a vertex as not yet queued
+	for(i=0; i<num; i++)
+		dist[i] = num;
+
+	for(i=start; i<end; i++) {
+		// count shortest paths by breadth-first search
+		queue[0] = G->arr[i];
+		dist[i] = 0;
+		sigma[i] = 1.0;
+		for(j=0, pop=1; j<pop; j++) {
+			v = queue[j]->id;
+			for(li = queue[j]->qu->li; li != NULL; li = li->ne) {
+				w = li->ve->id;
+				if(dist[w] == num) {
+					queue[pop] = li->ve;
+					pop++;
+					dist[w] = dist[v] + 1;
+				}
+				if(dist[w] == dist[v] + 1) sigma[w] += sigma[v];
+			}
+		}
+
+		// accumulate dependencies in order of non-increasing distance
+		// the predecessors of w are the neighbours one level closer
+		for(j=pop; j > 1; j--) {
+			w = queue[j-1]->id;
+			for(li = queue[j-1]->qu->li; li != NULL; li = li->ne) {
+				v = li->ve->id;
+				if(dist[v] + 1 == dist[w])
+					delta[v] += sigma[v] / sigma[w] * (1.0 + delta[w]);
+			}
+			btw[w] += delta[w];
+		}
+
+		// reset helper arrays for the vertices we reached
+		for(j=0; j<pop; j++) {
+			v = queue[j]->id;
+			dist[v] = num;
+			sigma[v] = 0.0;
+			delta[v] = 0.0;
+		}
+	}
+
+	free(sigma);
+	free(delta);
+	free(dist);
+	free(queue);
+
+	((struct gsegment *)seg)->btw = btw;
+
+	return (void *) 0;
+}
+
+
+/*
+ * Calculates the betweenness centrality of all vertices of an undirected
+ * graph using numThreads threads. Entry i of the returned array is the
+ * number of shortest paths between pairs of other vertices passing through
+ * the vertex with id i, where each path is weighted by one over the number
+ * of shortest paths between its end points.
+ */
+DOUBLE *threadedbetweenness(struct graph *G, INT numThreads) {
+	struct gsegment *segList;	// arguments for the separate threads
+	DOUBLE *btw;
+	INT i, t;
+
+
+	/* sanity checks */
+	if(numThreads <= 0 || G->num < 1) return NULL;
+	if(numThreads > G->num) numThreads = G->num;
+
+	/* every thread takes a share of the source vertices */
+	segList = makesegments(G, 0, G->num, numThreads);
+	if(runsegments(segList, numThreads, &betweenness)) {
+		fprintf(stderr, "Error calculating betweenness centrality.\n");
+		exit(-1);
+	}
+
+	/* merge the partial results, each pair got counted in both directions */
+	btw = segList[0].btw;
+	for(t=1; t<numThreads; t++) {
+		for(i=0; i<G->num; i++)
+			btw[i] += segList[t].btw[i];
+		free(segList[t].btw);
+	}
+	for(i=0; i<G->num; i++)
+		btw[i] /= 2.0;
+
+	free(segList);
+
+	return btw;
+}
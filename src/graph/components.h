@@ -0,0 +1,211 @@
+/*
+ * Connected components of a graph
+ *
+ * The vertices are split into ranges, one for each thread, and every thread
+ * merges the components of the end points of the edges of its vertices in a
+ * common union-find structure. A component is represented by its smallest
+ * vertex: a union hooks the larger of the two representatives below the
+ * smaller one with a compare-and-swap, so no locks are needed and parents
+ * only ever point to smaller vertices. Finding a representative halves the
+ * path to it.
+ *
+ * Usage:
+ *		comp = components(G, numThreads, &numcomp);
+ *		C = splitgraph(G, comp, numcomp);
+ */
+
+
+#define UFMINVERTICES 65536	// minimal number of vertices per thread
+
+
+struct ufarg {
+	struct graph *G;
+	_Atomic INT *parent;
+	INT start;
+	INT end;
+};
+
+
+// representative of the component of v
+INT uffind(_Atomic INT *parent, INT v) {
+	INT p, g;
+
+	while(1) {
+		p = atomic_load_explicit(&parent[v], memory_order_relaxed);
+		if(p == v) return v;
+		g = atomic_load_explicit(&parent[p], memory_order_relaxed);
+		if(g != p) atomic_compare_exchange_weak_explicit(&parent[v], &p, g, memory_order_relaxed, memory_order_relaxed);
+		v = g;
+	}
+}
+
+
+// merges the components of u and v
+void ufunion(_Atomic INT *parent, INT u, INT v) {
+	INT t;
+
+	while(1) {
+		u = uffind(parent, u);
+		v = uffind(parent, v);
+		if(u == v) return;
+		if(u < v) {
+			t = u;
+			u = v;
+			v = t;
+		}
+		// u is larger, it may have become a child in the meantime
+		t = u;
+		if(atomic_compare_exchange_strong_explicit(&parent[u], &t, v, memory_order_relaxed, memory_order_relaxed))
+			return;
+	}
+}
+
+
+void *ufthread(void *arg) {
+	struct ufarg *a = (struct ufarg *) arg;
+	struct list *li;
+	INT i, j;
+
+	for(i = a->start; i < a->end; i++) {
+		for(li = a->G->arr[i]->qu->li; li != NULL; li = li->ne) {
+			j = li->ve->id;
+			if(j != i) ufunion(a->parent, i, j);
+		}
+	}
+
+	return NULL;
+}
+
+
+/*
+ * Returns the component of every vertex and sets *numcomp to their number.
+ * The components are numbered in the order of their smallest vertices.
+ */
+INT *components(struct graph *G, INT numThreads, INT *numcomp) {
+	_Atomic INT *parent;
+	struct ufarg *args;
+	pthread_t *th;
+	INT *comp;
+	INT i, k, nt;
+
+	parent = (_Atomic INT *) malloc((G->num + 1) * sizeof(_Atomic INT));
+	comp = (INT *) malloc((G->num + 1) * sizeof(INT));
+	if(parent == NULL || comp == NULL) {
+		fprintf(stderr, "Memory allocation error in function components.\n");
+		exit(-1);
+	}
+	for(i=0; i<G->num; i++)
+		atomic_init(&parent[i], i);
+
+	/* merge along the edges in parallel */
+	nt = G->num / UFMINVERTICES;
+	if(nt > numThreads) nt = numThreads;
+	if(nt < 1) nt = 1;
+	args = (struct ufarg *) calloc(nt, sizeof(struct ufarg));
+	th = (pthread_t *) calloc(nt, sizeof(pthread_t));
+	if(args == NULL || th == NULL) {
+		fprintf(stderr, "Memory allocation error in function components.\n");
+		exit(-1);
+	}
+	for(k=0; k<nt; k++) {
+		args[k].G = G;
+		args[k].parent = parent;
+		args[k].start = k * (G->num / nt);
+		args[k].end = (k + 1 == nt) ? G->num : (k + 1) * (G->num / nt);
+		if(pthread_create(&th[k], NULL, &ufthread, &args[k])) {
+			fprintf(stderr, "Error launching thread number %"STR(FINT)"\n", k);
+			exit(-1);
+		}
+	}
+	for(k=0; k<nt; k++)
+		pthread_join(th[k], NULL);
+
+	/* number the representatives, they precede the rest of their component */
+	*numcomp = 0;
+	for(i=0; i<G->num; i++) {
+		k = uffind(parent, i);
+		comp[i] = (k == i) ? (*numcomp)++ : comp[k];
+	}
+
+	free(parent);
+	free(args);
+	free(th);
+
+	return comp;
+}
+
+
+/*
+ * Splits G into the graphs of its components. The vertices of a component
+ * keep their order and their attributes, the root of G becomes the root of
+ * its component.
+ */
+struct graph **splitgraph(struct graph *G, INT *comp, INT numcomp) {
+	struct graph **C;
+	struct csr *S;
+	struct list *li;
+	struct vertex *v;
+	INT *loc, *pos;
+	INT i, c;
+
+	C = (struct graph **) calloc(numcomp, sizeof(struct graph *));
+	S = (struct csr *) calloc(numcomp, sizeof(struct csr));
+	pos = (INT *) calloc(numcomp, sizeof(INT));
+	loc = (INT *) malloc((G->num + 1) * sizeof(INT));
+	if(C == NULL || S == NULL || pos == NULL || loc == NULL) {
+		fprintf(stderr, "Memory allocation error in function splitgraph.\n");
+		exit(-1);
+	}
+
+	/* number of vertices and list entries of every component */
+	for(i=0; i<G->num; i++) {
+		c = comp[i];
+		loc[i] = S[c].num++;
+		for(li = G->arr[i]->qu->li; li != NULL; li = li->ne)
+			pos[c]++;
+	}
+	for(c=0; c<numcomp; c++) {
+		S[c].off = (INT *) malloc((S[c].num + 1) * sizeof(INT));
+		S[c].adj = (INT *) malloc((pos[c] + 1) * sizeof(INT));
+		if(S[c].off == NULL || S[c].adj == NULL) {
+			fprintf(stderr, "Memory allocation error in function splitgraph.\n");
+			exit(-1);
+		}
+		pos[c] = 0;
+	}
+
+	/* the lists of a component are filled in the order of its vertices */
+	for(i=0; i<G->num; i++) {
+		c = comp[i];
+		S[c].off[loc[i]] = pos[c];
+		for(li = G->arr[i]->qu->li; li != NULL; li = li->ne)
+			S[c].adj[pos[c]++] = loc[li->ve->id];
+	}
+
+	for(c=0; c<numcomp; c++) {
+		S[c].off[S[c].num] = pos[c];
+		C[c] = csr2graph(&S[c]);
+		free(S[c].off);
+		free(S[c].adj);
+	}
+	if(G->root != NULL) C[comp[G->root->id]]->root = C[comp[G->root->id]]->arr[loc[G->root->id]];
+
+	/* vertex attributes read from the input file */
+	for(i=0; i<G->num; i++) {
+		v = C[comp[i]]->arr[loc[i]];
+		v->deg = G->arr[i]->deg;
+		v->height = G->arr[i]->height;
+		v->cent = G->arr[i]->cent;
+	}
+	// the parents give the heights from the root only in its component
+	for(c=0; c<numcomp; c++) {
+		C[c]->attr = G->attr;
+		if(G->root == NULL || c != comp[G->root->id]) C[c]->attr &= ~GATTR_PARENT;
+	}
+
+	free(S);
+	free(pos);
+	free(loc);
+
+	return C;
+}
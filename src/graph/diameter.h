@@ -0,0 +1,355 @@
+/*
+ *	We calculate the diameter, the radius and a center vertex of a
+ *  connected graph using a small number of breadth-first searches
+ *
+ *  Trees: the vertex a farthest away from an arbitrary vertex is the end
+ *  point of a longest path. A second search from a yields the diameter D
+ *  and the other end point b. The vertex on the path from b to a at
+ *  distance floor(D/2) from b is a center and the radius is ceil(D/2).
+ *
+ *  Graphs: the diameter is computed by the iFUB algorithm [1], starting
+ *  from the 4-sweep heuristic. The eccentricity of every source of a BFS
+ *  is known exactly, and every BFS bounds the eccentricities of all other
+ *  vertices [2]. We use these bounds to find the radius with the same
+ *  breadth-first searches plus a few more.
+ *
+ *  In graphs with a small diameter the fringe levels of iFUB are large. The
+ *  searches from the vertices of a level are independent and run on
+ *  numThreads threads, each thread keeps its own bounds that are merged
+ *  afterwards. If the bounds for the radius do not close after DIAMSWEEPS
+ *  further searches, the remaining candidates are searched in one threaded
+ *  pass.
+ *
+ * References:
+ *
+ * [1] P. Crescenzi, R. Grossi, M. Habib, L. Lanzi, A. Marino, On computing
+ * the diameter of real-world undirected graphs, Theoretical Computer Science
+ * 514 (2013), 84-95
+ *
+ * [2] F. W. Takes, W. A. Kosters, Computing the eccentricity distribution of
+ * large graphs, Algorithms 6 (2013), 100-118
+ */
+
+
+#define DIAMSWEEPS 16		// searches for the radius before the threaded pass
+#define DIAMBLOCK 8			// searches of a fringe level that run at once
+
+
+// the result of a diameter calculation
+struct diam {
+	INT diameter;
+	INT radius;
+	struct vertex *center;	// a vertex with eccentricity equal to the radius
+	INT numbfs;				// number of breadth-first searches performed
+};
+
+
+// helper arrays that are shared by all breadth-first searches
+struct eccbounds {
+	INT *lo;				// lower bounds for the eccentricities
+	INT *up;				// upper bounds for the eccentricities
+	INT *dist;				// distances from the last source
+	struct vertex **queue;	// bfs order of the last search
+	INT cnt;				// number of vertices reached by the last search
+	INT numbfs;				// number of searches so far
+};
+
+
+/*
+ * walks from v towards the source of the last search for steps many steps
+ * along a shortest path
+ */
+struct vertex *walkback(struct vertex *v, INT *dist, INT steps) {
+	struct list *li;
+
+	while(steps > 0 && dist[v->id] > 0) {
+		for(li = v->qu->li; li != NULL; li = li->ne) {
+			if(dist[li->ve->id] + 1 == dist[v->id]) {
+				v = li->ve;
+				break;
+			}
+		}
+		steps--;
+	}
+
+	return v;
+}
+
+
+/*
+ * Diameter, radius and center of a tree
+ */
+void treediameter(struct graph *G, struct vertex *root, struct diam *res) {
+	INT *dist, cnt;
+	struct vertex **queue;
+	struct vertex *a, *b;
+
+	dist = (INT *) calloc(G->num, sizeof(INT));
+	queue = (struct vertex **) calloc(G->num, sizeof(struct vertex *));
+	if(dist == NULL || queue == NULL) {
+		fprintf(stderr, "Memory allocation error in function treediameter.\n");
+		exit(-1);
+	}
+
+	// the last vertex in bfs order is farthest away from the source
+	cnt = bfsdist(G, root, dist, queue);
+	a = queue[cnt-1];
+
+	cnt = bfsdist(G, a, dist, queue);
+	b = queue[cnt-1];
+
+	res->diameter = dist[b->id];
+	res->radius = (res->diameter + 1) / 2;
+	res->center = walkback(b, dist, res->diameter / 2);
+	res->numbfs = 2;
+
+	free(dist);
+	free(queue);
+}
+
+
+/*
+ * Runs a breadth-first search from s and updates the eccentricity bounds
+ * Returns the eccentricity of s
+ */
+INT eccsweep(struct graph *G, struct vertex *s, struct eccbounds *eb) {
+	INT i, ecc, d;
+
+	eb->cnt = bfsdist(G, s, eb->dist, eb->queue);
+	eb->numbfs++;
+	ecc = eb->dist[eb->queue[eb->cnt-1]->id];
+
+	for(i=0; i<G->num; i++) {
+		d = eb->dist[i];
+		if(d > eb->lo[i]) eb->lo[i] = d;
+		if(ecc - d > eb->lo[i]) eb->lo[i] = ecc - d;
+		if(ecc + d < eb->up[i]) eb->up[i] = ecc + d;
+	}
+	eb->lo[s->id] = ecc;
+	eb->up[s->id] = ecc;
+
+	return ecc;
+}
+
+
+// data that gets passed to a thread of parsweeps()
+struct sweepseg {
+	struct graph *G;
+	struct vertex **src;	// sources of the searches of this thread
+	INT num;				// number of sources
+	INT maxecc;				// largest eccentricity of the sources
+	struct eccbounds eb;	// bounds found by this thread
+	pthread_t th;
+};
+
+
+// searches from the sources of a segment with the bounds of the segment
+void *sweepthread(void *arg) {
+	struct sweepseg *seg = (struct sweepseg *) arg;
+	INT i, ecc;
+
+	seg->maxecc = 0;
+	for(i=0; i<seg->num; i++) {
+		ecc = eccsweep(seg->G, seg->src[i], &seg->eb);
+		if(ecc > seg->maxecc) seg->maxecc = ecc;
+	}
+
+	return NULL;
+}
+
+
+// helper arrays for the threads of parsweeps()
+struct sweepseg *newsweepsegs(struct graph *G, INT numThreads) {
+	struct sweepseg *seg;
+	INT k;
+
+	seg = (struct sweepseg *) calloc(numThreads, sizeof(struct sweepseg));
+	if(seg == NULL) {
+		fprintf(stderr, "Memory allocation error in function newsweepsegs.\n");
+		exit(-1);
+	}
+	for(k=0; k<numThreads; k++) {
+		seg[k].G = G;
+		seg[k].eb.lo = (INT *) malloc(G->num * sizeof(INT));
+		seg[k].eb.up = (INT *) malloc(G->num * sizeof(INT));
+		seg[k].eb.dist = (INT *) malloc(G->num * sizeof(INT));
+		seg[k].eb.queue = (struct vertex **) malloc(G->num * sizeof(struct vertex *));
+		if(seg[k].eb.lo == NULL || seg[k].eb.up == NULL || seg[k].eb.dist == NULL || seg[k].eb.queue == NULL) {
+			fprintf(stderr, "Memory allocation error in function newsweepsegs.\n");
+			exit(-1);
+		}
+	}
+
+	return seg;
+}
+
+
+void freesweepsegs(struct sweepseg *seg, INT numThreads) {
+	INT k;
+
+	for(k=0; k<numThreads; k++) {
+		free(seg[k].eb.lo);
+		free(seg[k].eb.up);
+		free(seg[k].eb.dist);
+		free(seg[k].eb.queue);
+	}
+	free(seg);
+}
+
+
+/*
+ * Runs breadth-first searches from the num vertices in src on at most
+ * numThreads threads with the helper arrays seg and merges the bounds they
+ * find into eb. Returns the largest eccentricity of the sources.
+ */
+INT parsweeps(struct graph *G, struct vertex **src, INT num, struct sweepseg *seg, INT numThreads, struct eccbounds *eb) {
+	INT i, k, n, maxecc;
+
+	if(num == 0) return 0;
+	n = (numThreads < num) ? numThreads : num;
+
+	for(k=0; k<n; k++) {
+		seg[k].src = src + (num * k) / n;
+		seg[k].num = (num * (k + 1)) / n - (num * k) / n;
+		memcpy(seg[k].eb.lo, eb->lo, G->num * sizeof(INT));
+		memcpy(seg[k].eb.up, eb->up, G->num * sizeof(INT));
+		seg[k].eb.numbfs = 0;
+		if(pthread_create(&seg[k].th, NULL, &sweepthread, &seg[k])) {
+			fprintf(stderr, "Error launching thread in function parsweeps.\n");
+			exit(-1);
+		}
+	}
+
+	// the bounds of all threads hold, merge them
+	maxecc = 0;
+	for(k=0; k<n; k++) {
+		pthread_join(seg[k].th, NULL);
+		for(i=0; i<G->num; i++) {
+			if(seg[k].eb.lo[i] > eb->lo[i]) eb->lo[i] = seg[k].eb.lo[i];
+			if(seg[k].eb.up[i] < eb->up[i]) eb->up[i] = seg[k].eb.up[i];
+		}
+		if(seg[k].maxecc > maxecc) maxecc = seg[k].maxecc;
+		eb->numbfs += seg[k].eb.numbfs;
+	}
+
+	return maxecc;
+}
+
+
+/*
+ * Diameter, radius and center of a connected graph, the searches of the
+ * fringe levels and of the threaded pass for the radius run on numThreads
+ * threads
+ */
+void graphdiameter(struct graph *G, struct vertex *root, INT numThreads, struct diam *res) {
+	struct eccbounds eb;
+	struct sweepseg *seg;
+	struct vertex *a, *u, **fringe, **src;
+	INT *levu;
+	INT i, k, c, pos, lb, ub, ecc, bi, best, sweeps;
+
+	if(numThreads < 1) numThreads = 1;
+
+	eb.lo = (INT *) calloc(G->num, sizeof(INT));
+	eb.up = (INT *) calloc(G->num, sizeof(INT));
+	eb.dist = (INT *) calloc(G->num, sizeof(INT));
+	eb.queue = (struct vertex **) calloc(G->num, sizeof(struct vertex *));
+	fringe = (struct vertex **) calloc(G->num, sizeof(struct vertex *));
+	levu = (INT *) calloc(G->num, sizeof(INT));
+	src = (struct vertex **) calloc(G->num, sizeof(struct vertex *));
+	if(eb.lo == NULL || eb.up == NULL || eb.dist == NULL || eb.queue == NULL || fringe == NULL || levu == NULL || src == NULL) {
+		fprintf(stderr, "Memory allocation error in function graphdiameter.\n");
+		exit(-1);
+	}
+	for(i=0; i<G->num; i++) {
+		eb.lo[i] = 0;
+		eb.up[i] = G->num;
+	}
+	eb.numbfs = 0;
+	seg = newsweepsegs(G, numThreads);
+
+	/* 4-sweep: two double sweeps, the second from the middle of the first path */
+	u = root;
+	lb = 0;
+	for(k=0; k<2; k++) {
+		eccsweep(G, u, &eb);
+		a = eb.queue[eb.cnt-1];
+		ecc = eccsweep(G, a, &eb);
+		if(ecc > lb) lb = ecc;
+		u = walkback(eb.queue[eb.cnt-1], eb.dist, ecc / 2);
+	}
+
+	/* iFUB: eccentricities of the fringe levels of a search from u */
+	ecc = eccsweep(G, u, &eb);
+	if(ecc > lb) lb = ecc;
+	ub = 2 * ecc;
+
+	// save the levels of the search from u, the bfs order lists the
+	// vertices level by level
+	for(i=0; i<eb.cnt; i++) {
+		fringe[i] = eb.queue[i];
+		levu[i] = eb.dist[eb.queue[i]->id];
+	}
+	pos = eb.cnt;
+
+	for(i=ecc; ub > lb && i > 0; i--) {
+		// bi = maximal eccentricity of the vertices at level i, the
+		// searches run in blocks of DIAMBLOCK vertices (independent of the
+		// number of threads, so the bounds are the same for every number of
+		// threads), vertices that cannot increase the lower bound or bi
+		// are skipped
+		for(bi=0; pos > 0 && levu[pos-1] == i; ) {
+			for(c=0; c < DIAMBLOCK && pos > 0 && levu[pos-1] == i; pos--) {
+				u = fringe[pos-1];
+				if(eb.up[u->id] <= lb || eb.up[u->id] <= bi) continue;
+				if(eb.lo[u->id] == eb.up[u->id]) {
+					if(eb.lo[u->id] > bi) bi = eb.lo[u->id];
+				} else {
+					src[c++] = u;
+				}
+			}
+			ecc = parsweeps(G, src, c, seg, numThreads, &eb);
+			if(ecc > bi) bi = ecc;
+		}
+		if(bi > lb) lb = bi;
+
+		// vertices at levels < i have pairwise distance <= 2(i-1)
+		if(lb > 2*(i-1)) break;
+		ub = 2*(i-1);
+	}
+	res->diameter = lb;
+
+	/* radius: search from the vertex with the smallest lower bound until
+	 * no lower bound is below the best upper bound */
+	for(sweeps=0; ; sweeps++) {
+		// k = vertex of unknown eccentricity with the smallest lower bound
+		for(i=0, best=0, k=G->num; i<G->num; i++) {
+			if(eb.up[i] < eb.up[best]) best = i;
+			if(eb.lo[i] < eb.up[i] && (k == G->num || eb.lo[i] < eb.lo[k])) k = i;
+		}
+		if(k == G->num || eb.lo[k] >= eb.up[best]) break;
+
+		if(sweeps < DIAMSWEEPS) {
+			eccsweep(G, G->arr[k], &eb);
+		} else {
+			// the bounds do not close, search from all candidates at once,
+			// afterwards their eccentricities are known
+			for(i=0, c=0; i<G->num; i++) {
+				if(eb.lo[i] < eb.up[i] && eb.lo[i] < eb.up[best]) src[c++] = G->arr[i];
+			}
+			parsweeps(G, src, c, seg, numThreads, &eb);
+		}
+	}
+	res->radius = eb.up[best];
+	res->center = G->arr[best];
+	res->numbfs = eb.numbfs;
+
+	freesweepsegs(seg, numThreads);
+	free(src);
+	free(levu);
+	free(fringe);
+	free(eb.lo);
+	free(eb.up);
+	free(eb.dist);
+	free(eb.queue);
+}
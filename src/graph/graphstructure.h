@@ -30,6 +30,16 @@ struct vertex {
 };
 
 
+// vertex attributes in graphml files
+#define GATTR_DEG 1			// deg
+#define GATTR_HEIGHT 2		// height
+#define GATTR_CENT 4		// cent, the sum of the distances
+#define GATTR_PARENT 8		// the neighbour with height one less
+#define GATTRNUM 4
+
+const char *gattrnames[GATTRNUM] = {"deg", "height", "distsum", "parent"};
+
+
 struct graph {				// holds a graph; optional arguments need to 
 							// be initialized with NULL
 	INT num;				// the number of vertices
@@ -41,6 +51,27 @@ struct graph {				// holds a graph; optional arguments need to
 	struct vertex **dfs;	// dynamically allocated array with pointers
    							// to all vertices (optional)
 	int disconnected;		// warning flag if the graph is disconnected
+	int attr;				// vertex attributes read from the input file
+							// (GATTR_* flags)
+	struct vertex *vpool;	// if not NULL, all vertices, queues and list
+	struct queue *qpool;	// entries are stored in these three blocks
+	struct list *lpool;		// instead of being allocated one by one
+};
+
+
+struct csr {				// compressed sparse row representation of a
+							// directed graph
+	INT num;				// the number of vertices
+	INT *off;				// the neighbours of vertex v are
+	INT *adj;				// adj[off[v]], ..., adj[off[v+1]-1]
+};
+
+
+struct roots {				// root vertices given by their ids in an
+							// input file
+	char **id;				// the ids
+	INT num;				// number of ids
+	struct vertex **v;		// the vertices, set when the file is read
 };
 
 
@@ -75,6 +106,10 @@ struct graph* newgraph(INT num) {
 	G->bfs = NULL;
 	G->dfs = NULL;
 	G->disconnected = 0;
+	G->attr = 0;
+	G->vpool = NULL;
+	G->qpool = NULL;
+	G->lpool = NULL;
 
 	G->arr = (struct vertex **) calloc(num, sizeof(struct vertex *));
 	if(G->arr == NULL) {
@@ -99,6 +134,65 @@ struct graph* newgraph(INT num) {
 }
 
 
+/*
+ * Generates the graph given by a compressed sparse row structure. The
+ * neighbourhood lists keep the order of C->adj. Vertices, queues and list
+ * entries are allocated in three blocks, which saves the overhead of one
+ * malloc per edge. Edges of such a graph must not be removed with delli().
+ */
+struct graph *csr2graph(struct csr *C) {
+	INT i, k, num, m;
+	struct graph *G;
+	struct vertex *v;
+
+	num = C->num;
+	m = C->off[num];
+
+	G = (struct graph *) malloc(sizeof(struct graph));
+	if(G == NULL) {
+		fprintf(stderr, "Memory allocation error in function csr2graph.\n");
+		exit(-1);
+	}
+
+	G->num = num;
+	G->root = NULL;
+	G->bfs = NULL;
+	G->dfs = NULL;
+	G->disconnected = 0;
+	G->attr = 0;
+
+	G->arr = (struct vertex **) calloc(num, sizeof(struct vertex *));
+	G->vpool = (struct vertex *) calloc(num + 1, sizeof(struct vertex));
+	G->qpool = (struct queue *) calloc(num + 1, sizeof(struct queue));
+	G->lpool = (struct list *) calloc(m + 1, sizeof(struct list));
+	if(G->arr == NULL || G->vpool == NULL || G->qpool == NULL || G->lpool == NULL) {
+		fprintf(stderr, "Memory allocation error in function csr2graph.\n");
+		exit(-1);
+	}
+
+	for(i=0; i<num; i++) {
+		v = &G->vpool[i];
+		G->arr[i] = v;
+		v->id = i;
+		v->qu = &G->qpool[i];
+		v->deg = 0;
+		v->height = 0;
+		v->cent = 0;
+
+		// link the list entries of vertex i
+		v->qu->li = (C->off[i] < C->off[i+1]) ? &G->lpool[C->off[i]] : NULL;
+		v->qu->lie = (C->off[i] < C->off[i+1]) ? &G->lpool[C->off[i+1] - 1] : NULL;
+		for(k = C->off[i]; k < C->off[i+1]; k++) {
+			G->lpool[k].ve = &G->vpool[C->adj[k]];
+			G->lpool[k].ne = (k + 1 < C->off[i+1]) ? &G->lpool[k+1] : NULL;
+			G->lpool[k].pr = (k > C->off[i]) ? &G->lpool[k-1] : NULL;
+		}
+	}
+
+	return G;
+}
+
+
 // insert list entry to the right
 // returns address of new entry
 struct list *insr(struct list *li, struct vertex *v) {
@@ -259,12 +353,19 @@ void free_graph(struct graph *G) {
 	INT i;
 
 
-	for(i=0; i<G->num; i++) {
-		// free edges
-		delqueue(G->arr[i]->qu);	
+	if(G->vpool != NULL) {
+		// vertices and edges were allocated in blocks by csr2graph
+		free(G->lpool);
+		free(G->qpool);
+		free(G->vpool);
+	} else {
+		for(i=0; i<G->num; i++) {
+			// free edges
+			delqueue(G->arr[i]->qu);	
 
-		// free vertex
-		free(G->arr[i]);
+			// free vertex
+			free(G->arr[i]);
+		}
 	}
 
 	// free vertex arrays
@@ -277,33 +378,178 @@ void free_graph(struct graph *G) {
 }
 
 
+// the node with id i
+void graphmlnode(struct obuf *B, INT i, void *ctx) {
+	obputs(B, "    <node id='");
+	obputu(B, i);
+	obputs(B, "' />\n");
+}
+
+
+struct graphmlctx {
+	struct graph *G;
+	int attr;
+};
+
+void graphmldata(struct obuf *B, int k, unsigned long long x) {
+	obputs(B, "      <data key='");
+	obputs(B, gattrnames[k]);
+	obputs(B, "'>");
+	obputu(B, x);
+	obputs(B, "</data>\n");
+}
+
+// the node with id i and its attributes
+void graphmlattrnode(struct obuf *B, INT i, void *ctx) {
+	struct graphmlctx *c = (struct graphmlctx *) ctx;
+	struct vertex *v = c->G->arr[i];
+	struct list *li;
+
+	obputs(B, "    <node id='");
+	obputu(B, i);
+	obputs(B, "'>\n");
+	if(c->attr & GATTR_DEG) graphmldata(B, 0, v->deg);
+	if(c->attr & GATTR_HEIGHT) graphmldata(B, 1, v->height);
+	if(c->attr & GATTR_CENT) graphmldata(B, 2, v->cent);
+	if((c->attr & GATTR_PARENT) && v->height > 0) {
+		for(li = v->qu->li; li != NULL && li->ve->height + 1 != v->height; li = li->ne);
+		if(li != NULL) graphmldata(B, 3, li->ve->id);
+	}
+	obputs(B, "    </node>\n");
+}
+
+// the edges from vertex i to vertices with larger ids
+// in order to avoid writing an edge twice we only write the edge
+// if the id of the source is smaller than the id of the target
+void graphmledges(struct obuf *B, INT i, void *ctx) {
+	struct graph *G = (struct graph *) ctx;
+	struct list *li;
+
+	for(li = G->arr[i]->qu->li; li != NULL; li = li->ne) {
+		if(li->ve->id > G->arr[i]->id) {
+			obputs(B, "    <edge source='");
+			obputu(B, G->arr[i]->id);
+			obputs(B, "' target='");
+			obputu(B, li->ve->id);
+			obputs(B, "' />\n");
+		}
+	}
+}
+
 /* 
  * outputs undirected graph in graphml format
  * assumption is that any edge corresponds to a pair of di-edges 
+ * the vertex attributes given by the GATTR_* flags in attr are written as
+ * <data> elements of the nodes, the parent of a vertex is the neighbour
+ * whose height is one less
  */ 
-void print_graphml(struct graph *G, FILE *outstream) {
-	INT i;
-	struct list *li;
-
-	fprintf(outstream, "<graphml>\n");
-	fprintf(outstream, "  <graph id='randomgraph' edgedefault='undirected'>\n");
+void print_graphmlattr(struct graph *G, FILE *outstream, int attr) {
+	struct obuf O;
+	struct graphmlctx c;
+	int k;
+
+	obopen(&O, outstream);
+	obputs(&O, "<graphml>\n");
+	for(k=0; k<GATTRNUM; k++) {
+		if(attr & (1 << k)) {
+			obputs(&O, "  <key id='");
+			obputs(&O, gattrnames[k]);
+			obputs(&O, "' for='node' attr.name='");
+			obputs(&O, gattrnames[k]);
+			obputs(&O, (k == 3) ? "' attr.type='string' />\n" : "' attr.type='long' />\n");
+		}
+	}
+	obputs(&O, "  <graph id='randomgraph' edgedefault='undirected'>\n");
 
 	// write nodes
-	for(i=0; i<G->num; i++) 
-		fprintf(outstream, "    <node id=\'%" STR(FINT) "\' />\n", i);
+	if(attr == 0) {
+		obformat(&O, G->num, &graphmlnode, G);
+	} else {
+		c.G = G;
+		c.attr = attr;
+		obformat(&O, G->num, &graphmlattrnode, &c);
+	}
 
 	// write edges
-	// in order to avoid writing an edge twice we only write the edge
-	// if the id of the source is smaller than the id of the target
-	for(i=0; i<G->num; i++) {
-		for(li = G->arr[i]->qu->li; li != NULL; li = li->ne) {
-			if(li->ve->id > G->arr[i]->id) {
-				fprintf(outstream, "    <edge source=\'%" STR(FINT) "\' target=\'%" STR(FINT) "\' />\n", G->arr[i]->id, li->ve->id);
-			}
-		}
+	obformat(&O, G->num, &graphmledges, G);
+
+	obputs(&O, "  </graph>\n");
+	obputs(&O, "</graphml>\n");
+	obclose(&O);
+}
+
+void print_graphml(struct graph *G, FILE *outstream) {
+	print_graphmlattr(G, outstream, 0);
+}
+
+
+/*
+ * Calls edge() for the edges of the looptree of the tree G that join the
+ * children of vertex i to a cycle through i, in the order of the list of i:
+ * i and its first child, consecutive children and the last child and i.
+ * The children are the neighbours one level further from the root, given
+ * by height (or by the heights of the vertices if height is NULL).
+ */
+void loopedges(struct graph *G, INT *height, INT i, void (*edge)(INT, INT, void *), void *arg) {
+	struct list *li;
+	INT h, prev, k;
+
+	h = (height != NULL) ? height[i] : G->arr[i]->height;
+	prev = i;
+	k = 0;
+	for(li = G->arr[i]->qu->li; li != NULL; li = li->ne) {
+		if(((height != NULL) ? height[li->ve->id] : li->ve->height) != h + 1) continue;
+		edge(prev, li->ve->id, arg);
+		prev = li->ve->id;
+		k++;
 	}
-	fprintf(outstream, "  </graph>\n");
-	fprintf(outstream, "</graphml>\n");
+	if(k >= 2) edge(prev, i, arg);
+}
+
+
+struct loopctx {
+	struct graph *G;
+	INT *height;
+};
+
+// an edge of the looptree, the smaller id is the source
+void graphmledge(INT s, INT t, void *arg) {
+	struct obuf *B = (struct obuf *) arg;
+
+	obputs(B, "    <edge source='");
+	obputu(B, (s < t) ? s : t);
+	obputs(B, "' target='");
+	obputu(B, (s < t) ? t : s);
+	obputs(B, "' />\n");
+}
+
+// the edges of the cycle through the children of vertex i
+void graphmlloopedges(struct obuf *B, INT i, void *ctx) {
+	struct loopctx *c = (struct loopctx *) ctx;
+
+	loopedges(c->G, c->height, i, &graphmledge, B);
+}
+
+/*
+ * outputs the looptree of the tree G in graphml format without building it,
+ * the heights are those of loopedges(); the file describes the same graph
+ * as print_graphml() of looptree(), only the edges come in another order
+ */
+void print_looptree(struct graph *G, INT *height, FILE *outstream) {
+	struct obuf O;
+	struct loopctx c;
+
+	c.G = G;
+	c.height = height;
+
+	obopen(&O, outstream);
+	obputs(&O, "<graphml>\n");
+	obputs(&O, "  <graph id='randomgraph' edgedefault='undirected'>\n");
+	obformat(&O, G->num, &graphmlnode, G);
+	obformat(&O, G->num, &graphmlloopedges, &c);
+	obputs(&O, "  </graph>\n");
+	obputs(&O, "</graphml>\n");
+	obclose(&O);
 }
 
 
@@ -365,6 +611,43 @@ struct vertex **dfsorder(struct graph *G, struct vertex *root) {
 	return dfs;
 }
 
+
+/*
+ * Depth-first-search order of the tree G from root, the same as dfsorder().
+ * The children of a vertex are the neighbours one level below, with the
+ * heights taken from the array height or from the vertices if it is NULL.
+ * G is only read, so several searches can run at the same time.
+ */
+struct vertex **treedfsorder(struct graph *G, struct vertex *root, INT *height) {
+	struct vertex **dfs, **stack;
+	struct vertex *v;
+	struct list *li;
+	INT i, top, h;
+
+	dfs = (struct vertex **) malloc(G->num * sizeof(struct vertex *));
+	stack = (struct vertex **) malloc(G->num * sizeof(struct vertex *));
+	if(dfs == NULL || stack == NULL) {
+		fprintf(stderr, "Error allocating memory in function treedfsorder.\n");
+		exit(-1);
+	}
+
+	// the neighbours are pushed from the end of the list, so the first
+	// child is visited first
+	top = 0;
+	stack[top++] = root;
+	for(i = 0; i < G->num && top > 0; i++) {
+		v = stack[--top];
+		dfs[i] = v;
+		h = (height != NULL) ? height[v->id] : v->height;
+		for(li = v->qu->lie; li != NULL; li = li->pr)
+			if(((height != NULL) ? height[li->ve->id] : li->ve->height) == h + 1)
+				stack[top++] = li->ve;
+	}
+
+	free(stack);
+	return dfs;
+}
+
 // calculate bfsorder of vertices
 // setheight --> sets height parameter for each vertex
 // setdeg --> sets deg = degree for each vertex
@@ -422,13 +705,41 @@ struct vertex **bfsorder(struct graph *G, struct vertex *root, int setdeg, int s
 	return bfs;
 }
 
+// calculate the distances from source to all vertices
+// dist[id] is set to G->num for vertices that cannot be reached
+// queue needs room for G->num vertices and holds the bfs order afterwards
+// returns the number of reached vertices
+INT bfsdist(struct graph *G, struct vertex *source, INT *dist, struct vertex **queue) {
+	struct list *li;
+	INT i, j, pop;
+
+	for(i = 0; i < G->num; i++)
+		dist[i] = G->num;
+
+	queue[0] = source;
+	dist[source->id] = 0;
+	for(j=0, pop=1; j<pop; j++) {
+		for(li = queue[j]->qu->li; li != NULL; li = li->ne) {
+			if(dist[li->ve->id] == G->num) {
+				dist[li->ve->id] = dist[queue[j]->id] + 1;
+				queue[pop] = li->ve;
+				pop++;
+			}
+		}
+	}
+
+	return pop;
+}
+
 // calculate looptree
+// the markers are kept apart from the vertices, so several looptrees of G
+// can be built at the same time
 struct graph *looptree(struct graph *G, struct vertex *root) {
 	struct vertex *v, *w, *x;
 	struct list *li;
 	struct queue *qu, *cyc;
 	struct graph *H;
-	INT i;
+	char *unqueued;
 	int flag;
 
 	/* sanity checks */
@@ -443,11 +754,13 @@ struct graph *looptree(struct graph *G, struct vertex *root) {
 	}
 
 
-	/* initialize vertex states */
-	for(i = 0; i < G->num; i++) {
-		/* initialize marker for vertices to state 'unqueued' */
-		G->arr[i]->x = 1;
+	/* initialize vertex states to 'unqueued' */
+	unqueued = (char *) malloc(G->num);
+	if(unqueued == NULL) {
+		fprintf(stderr, "Error allocating memory in function looptree.\n");
+		exit(-1);
 	}
+	memset(unqueued, 1, G->num);
 
 
 	qu = newqueue();
@@ -455,15 +768,15 @@ struct graph *looptree(struct graph *G, struct vertex *root) {
 	pushr(qu, root);
 
 	flag = 0;
-	root->x = 0;	// mark root as queued
+	unqueued[root->id] = 0;	// mark root as queued
 	while(qu->li) {
 		v = popl(qu);
 		for(li = v->qu->li; li != NULL; li = li->ne) {
 			// check if vertex was visited before
-			if(li->ve->x) {
+			if(unqueued[li->ve->id]) {
 				pushr(cyc, li->ve);
 				pushr(qu, li->ve);
-				li->ve->x = 0;	// mark vertex as queued
+				unqueued[li->ve->id] = 0;	// mark vertex as queued
 			}
 		}
 		// create cycle
@@ -490,6 +803,7 @@ struct graph *looptree(struct graph *G, struct vertex *root) {
 		
 	delqueue(cyc);
 	delqueue(qu);
+	free(unqueued);
 	return H;
 }
 
@@ -514,6 +828,75 @@ INT *makedegprofile(struct graph *G) {
 }
 
 
+/*
+ * Returns the width profile W[0], ..., W[*num-1], the number of vertices at
+ * every height. The heights are taken from the array height, or from the
+ * vertices if it is NULL.
+ */
+INT *makewidthprofile(struct graph *G, INT *height, INT *num) {
+	INT *W, i, h;
+
+	// the profile only needs as many entries as there are heights
+	*num = 0;
+	for(i=0; i<G->num; i++) {
+		h = (height != NULL) ? height[i] : G->arr[i]->height;
+		if(h >= *num) *num = h + 1;
+	}
+
+	W = (INT *) calloc(*num + 1, sizeof(INT));
+	if(W == NULL) {
+		fprintf(stderr, "Error allocating memory in function makewidthprofile.\n");
+		exit(-1);
+	}
+
+	for(i=0; i<G->num; i++)
+		W[(height != NULL) ? height[i] : G->arr[i]->height] += 1;
+
+	return W;
+}
+
+
+// prints the result of a check of the unit tests, returns 1 if it failed
+int unit_test_check(int ok, const char *name) {
+	printf("%s: %s\n", name, ok ? "PASS" : "FAIL");
+	return !ok;
+}
+
+// random tree with n vertices for the unit tests, vertex i > 0 is joined to
+// a uniformly chosen vertex among 0, ..., i-1
+struct graph *unit_test_tree(INT n) {
+	struct graph *G;
+	INT i;
+
+	G = newgraph(n);
+	for(i=1; i<n; i++)
+		addEdge(G->arr[(INT) rand() % i], G->arr[i]);
+
+	return G;
+}
+
+// checks if H has the edges of G with the vertex ids changed to map[id]
+// (unchanged if map is NULL), regardless of the order of the lists
+int unit_test_samegraph(struct graph *G, struct graph *H, INT *map) {
+	struct list *li, *lj;
+	INT i, v, w, dg, dh;
+
+	if(G->num != H->num) return 0;
+	for(i=0; i<G->num; i++) {
+		v = (map != NULL) ? map[i] : i;
+		for(dg=0, li = G->arr[i]->qu->li; li != NULL; li = li->ne, dg++) {
+			w = (map != NULL) ? map[li->ve->id] : li->ve->id;
+			for(lj = H->arr[v]->qu->li; lj != NULL && lj->ve->id != w; lj = lj->ne);
+			if(lj == NULL) return 0;
+		}
+		for(dh=0, lj = H->arr[v]->qu->li; lj != NULL; lj = lj->ne, dh++);
+		if(dg != dh) return 0;
+	}
+
+	return 1;
+}
+
+
 // unit test for the functions of this header file
 void unit_test_graph() {
 	struct graph *G, *H;	
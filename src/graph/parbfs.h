@@ -0,0 +1,441 @@
+/*
+ *	Level-synchronous parallel breadth-first search
+ *
+ *  parbfsorder() computes the same result as bfsorder(): the bfs order of
+ *  the vertices, their heights and degrees. Each level of the search is
+ *  expanded from the previous one, the frontier, in one of two ways:
+ *
+ *  Top-down: the frontier is split among the threads. Every unvisited
+ *  neighbour is claimed by the first frontier vertex that lists it, using an
+ *  atomic minimum of the positions in the bfs order. A second pass appends
+ *  every vertex to the buffer of the thread that holds its claimer, in the
+ *  order of the neighbourhood lists, so the new level is exactly the one of
+ *  the sequential search.
+ *
+ *  Bottom-up [1]: the unvisited vertices are split among the threads and
+ *  every one of them looks for a frontier vertex among the vertices that
+ *  list it, stopping at the first one. If the frontier holds a large part of
+ *  the edges, as in the middle levels of graphs with a small diameter, this
+ *  inspects far fewer edges. The new level consists of the same vertices as
+ *  in the sequential search, sorted by their ids. The reverse neighbourhood
+ *  lists are built before the first bottom-up step.
+ *
+ *  Small levels are expanded sequentially, so graphs with a large diameter
+ *  and small graphs do not pay for starting threads, and their bfs order is
+ *  the one of bfsorder().
+ *
+ * References:
+ *
+ * [1] S. Beamer, K. Asanovic, D. Patterson, Direction-optimizing
+ * breadth-first search, Scientific Programming 21 (2013), 137-148
+ */
+
+
+#define PBFSMINVERTICES (1UL << 16)	// smaller graphs use bfsorder()
+#define PBFSMINEDGES (1UL << 14)	// smaller levels are expanded sequentially
+#define PBFSALPHA 14				// go bottom-up if the frontier has more
+									// than 1/ALPHA of the unvisited edges
+#define PBFSBETA 24					// go top-down again if the frontier has
+									// less than 1/BETA of the vertices
+#define PBFSUNSET ((INT) -1)
+
+
+// state of a search, shared by all threads
+struct pbfs {
+	struct graph *G;
+	struct vertex **order;		// the bfs order found so far
+	_Atomic INT *level;			// height of every visited vertex
+	_Atomic INT *claim;			// position of the claiming frontier vertex
+	INT *deg;					// length of the neighbourhood lists
+	INT *roff;					// reverse neighbourhood lists, the vertices
+	INT *radj;					// listing v are radj[roff[v]], ...
+	INT fstart;					// the frontier is order[fstart], ...,
+	INT fend;					// order[fend-1]
+	INT d;						// level of the frontier
+};
+
+// data that gets passed to a thread
+struct pbfsarg {
+	struct pbfs *S;
+	INT start;					// range of frontier positions or vertices
+	INT end;
+	INT *buf;					// vertices of the next level
+	INT num;
+	INT cap;
+	_Atomic INT *pos;			// next free entries of the reverse lists
+};
+
+
+void pbfspush(struct pbfsarg *a, INT v) {
+	if(a->num == a->cap) {
+		a->cap = 2 * a->cap + 1024;
+		a->buf = (INT *) realloc(a->buf, a->cap * sizeof(INT));
+		if(a->buf == NULL) {
+			fprintf(stderr, "Memory allocation error in function pbfspush.\n");
+			exit(-1);
+		}
+	}
+	a->buf[a->num++] = v;
+}
+
+
+// top-down, first pass: claim the unvisited neighbours
+void *pbfsclaim(void *arg) {
+	struct pbfsarg *a = (struct pbfsarg *) arg;
+	struct pbfs *S = a->S;
+	struct list *li;
+	INT p, v, c;
+
+	for(p = a->start; p < a->end; p++) {
+		for(li = S->order[p]->qu->li; li != NULL; li = li->ne) {
+			v = li->ve->id;
+			if(atomic_load_explicit(&S->level[v], memory_order_relaxed) != PBFSUNSET) continue;
+			c = atomic_load_explicit(&S->claim[v], memory_order_relaxed);
+			while(p < c && !atomic_compare_exchange_weak_explicit(&S->claim[v], &c, p, memory_order_relaxed, memory_order_relaxed));
+		}
+	}
+
+	return NULL;
+}
+
+
+// top-down, second pass: collect the claimed vertices in list order
+void *pbfscollect(void *arg) {
+	struct pbfsarg *a = (struct pbfsarg *) arg;
+	struct pbfs *S = a->S;
+	struct list *li;
+	INT p, v;
+
+	for(p = a->start; p < a->end; p++) {
+		for(li = S->order[p]->qu->li; li != NULL; li = li->ne) {
+			v = li->ve->id;
+			// only this thread may set the level of v
+			if(atomic_load_explicit(&S->claim[v], memory_order_relaxed) == p
+				&& atomic_load_explicit(&S->level[v], memory_order_relaxed) == PBFSUNSET) {
+				atomic_store_explicit(&S->level[v], S->d + 1, memory_order_relaxed);
+				pbfspush(a, v);
+			}
+		}
+	}
+
+	return NULL;
+}
+
+
+// bottom-up: unvisited vertices look for a neighbour in the frontier
+void *pbfsbottomup(void *arg) {
+	struct pbfsarg *a = (struct pbfsarg *) arg;
+	struct pbfs *S = a->S;
+	INT v, k;
+
+	for(v = a->start; v < a->end; v++) {
+		if(atomic_load_explicit(&S->level[v], memory_order_relaxed) != PBFSUNSET) continue;
+		for(k = S->roff[v]; k < S->roff[v+1]; k++) {
+			if(atomic_load_explicit(&S->level[S->radj[k]], memory_order_relaxed) == S->d) {
+				atomic_store_explicit(&S->level[v], S->d + 1, memory_order_relaxed);
+				pbfspush(a, v);
+				break;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+
+// counts the lists that contain each vertex
+void *pbfsrcount(void *arg) {
+	struct pbfsarg *a = (struct pbfsarg *) arg;
+	struct list *li;
+	INT v;
+
+	for(v = a->start; v < a->end; v++) {
+		for(li = a->S->G->arr[v]->qu->li; li != NULL; li = li->ne)
+			atomic_fetch_add_explicit(&a->pos[li->ve->id], 1, memory_order_relaxed);
+	}
+
+	return NULL;
+}
+
+
+// fills the reverse lists
+void *pbfsrfill(void *arg) {
+	struct pbfsarg *a = (struct pbfsarg *) arg;
+	struct list *li;
+	INT v;
+
+	for(v = a->start; v < a->end; v++) {
+		for(li = a->S->G->arr[v]->qu->li; li != NULL; li = li->ne)
+			a->S->radj[atomic_fetch_add_explicit(&a->pos[li->ve->id], 1, memory_order_relaxed)] = v;
+	}
+
+	return NULL;
+}
+
+
+// list lengths
+void *pbfsdegrees(void *arg) {
+	struct pbfsarg *a = (struct pbfsarg *) arg;
+	struct list *li;
+	INT v;
+
+	for(v = a->start; v < a->end; v++) {
+		a->S->deg[v] = 0;
+		for(li = a->S->G->arr[v]->qu->li; li != NULL; li = li->ne)
+			a->S->deg[v]++;
+	}
+
+	return NULL;
+}
+
+
+// runs func on the range start, ..., end-1 split into numThreads parts
+void pbfsrun(struct pbfsarg *args, INT numThreads, INT start, INT end, void *(*func)(void *)) {
+	pthread_t *th;
+	INT k;
+
+	th = (pthread_t *) calloc(numThreads, sizeof(pthread_t));
+	if(th == NULL) {
+		fprintf(stderr, "Memory allocation error in function pbfsrun.\n");
+		exit(-1);
+	}
+	for(k=0; k<numThreads; k++) {
+		args[k].start = start + k * ((end - start) / numThreads);
+		args[k].end = (k + 1 == numThreads) ? end : start + (k + 1) * ((end - start) / numThreads);
+		args[k].num = 0;
+		if(pthread_create(&th[k], NULL, func, &args[k])) {
+			fprintf(stderr, "Error launching thread number %"STR(FINT)"\n", k);
+			exit(-1);
+		}
+	}
+	for(k=0; k<numThreads; k++)
+		pthread_join(th[k], NULL);
+
+	free(th);
+}
+
+
+// builds the reverse neighbourhood lists
+void pbfsreverse(struct pbfs *S, struct pbfsarg *args, INT numThreads) {
+	_Atomic INT *pos;
+	INT v, n, sum, c;
+
+	n = S->G->num;
+	pos = (_Atomic INT *) malloc((n + 1) * sizeof(_Atomic INT));
+	S->roff = (INT *) malloc((n + 1) * sizeof(INT));
+	if(pos == NULL || S->roff == NULL) {
+		fprintf(stderr, "Memory allocation error in function pbfsreverse.\n");
+		exit(-1);
+	}
+	for(v=0; v<n; v++)
+		atomic_init(&pos[v], 0);
+	for(v=0; v<numThreads; v++)
+		args[v].pos = pos;
+	pbfsrun(args, numThreads, 0, n, &pbfsrcount);
+
+	for(v=0, sum=0; v<n; v++) {
+		c = atomic_load_explicit(&pos[v], memory_order_relaxed);
+		S->roff[v] = sum;
+		atomic_store_explicit(&pos[v], sum, memory_order_relaxed);
+		sum += c;
+	}
+	S->roff[n] = sum;
+
+	S->radj = (INT *) malloc((sum + 1) * sizeof(INT));
+	if(S->radj == NULL) {
+		fprintf(stderr, "Memory allocation error in function pbfsreverse.\n");
+		exit(-1);
+	}
+	pbfsrun(args, numThreads, 0, n, &pbfsrfill);
+
+	free(pos);
+}
+
+
+/*
+ * Like bfsorder(): returns the vertices in bfs order from root, sets the
+ * heights if setheight and deg to the number of neighbours if setdeg, and
+ * sets G->disconnected if not all vertices are reached. Uses numThreads
+ * threads for large graphs.
+ */
+struct vertex **parbfsorder(struct graph *G, struct vertex *root, int setdeg, int setheight, INT numThreads) {
+	struct pbfs S;
+	struct pbfsarg *args;
+	struct list *li;
+	struct vertex *u;
+	INT i, k, n, p, v, mf, mu, cnt;
+	int bottomup;
+
+	/* sanity checks */
+	if(root == NULL || G == NULL) return NULL;
+	if(G->num < PBFSMINVERTICES || numThreads < 2) return bfsorder(G, root, setdeg, setheight);
+
+	n = G->num;
+	S.G = G;
+	S.order = (struct vertex **) calloc(n, sizeof(struct vertex *));
+	S.level = (_Atomic INT *) malloc(n * sizeof(_Atomic INT));
+	S.claim = (_Atomic INT *) malloc(n * sizeof(_Atomic INT));
+	S.deg = (INT *) malloc(n * sizeof(INT));
+	args = (struct pbfsarg *) calloc(numThreads, sizeof(struct pbfsarg));
+	if(S.order == NULL || S.level == NULL || S.claim == NULL || S.deg == NULL || args == NULL) {
+		fprintf(stderr, "Memory allocation error in function parbfsorder.\n");
+		exit(-1);
+	}
+	S.roff = NULL;
+	S.radj = NULL;
+	for(i=0; i<n; i++) {
+		atomic_init(&S.level[i], PBFSUNSET);
+		atomic_init(&S.claim[i], PBFSUNSET);
+	}
+	for(k=0; k<numThreads; k++)
+		args[k].S = &S;
+	pbfsrun(args, numThreads, 0, n, &pbfsdegrees);
+
+	// edges of the unvisited vertices
+	for(i=0, mu=0; i<n; i++)
+		mu += S.deg[i];
+
+	S.order[0] = root;
+	atomic_store_explicit(&S.level[root->id], 0, memory_order_relaxed);
+	mu -= S.deg[root->id];
+	S.fstart = 0;
+	S.fend = 1;
+	S.d = 0;
+	bottomup = 0;
+
+	while(S.fstart < S.fend) {
+		for(p = S.fstart, mf = 0; p < S.fend; p++)
+			mf += S.deg[S.order[p]->id];
+
+		// choose the direction of this step
+		if(!bottomup && mf > mu / PBFSALPHA) bottomup = 1;
+		else if(bottomup && (S.fend - S.fstart) * PBFSBETA < n) bottomup = 0;
+
+		cnt = S.fend;
+		if(bottomup) {
+			if(S.roff == NULL) pbfsreverse(&S, args, numThreads);
+			pbfsrun(args, numThreads, 0, n, &pbfsbottomup);
+		} else if(mf >= PBFSMINEDGES) {
+			pbfsrun(args, numThreads, S.fstart, S.fend, &pbfsclaim);
+			pbfsrun(args, numThreads, S.fstart, S.fend, &pbfscollect);
+		} else {
+			// sequential expansion of a small level
+			for(p = S.fstart; p < S.fend; p++) {
+				for(li = S.order[p]->qu->li; li != NULL; li = li->ne) {
+					v = li->ve->id;
+					if(atomic_load_explicit(&S.level[v], memory_order_relaxed) == PBFSUNSET) {
+						atomic_store_explicit(&S.level[v], S.d + 1, memory_order_relaxed);
+						S.order[cnt++] = li->ve;
+					}
+				}
+			}
+		}
+
+		// append the buffers of the threads in their order
+		if(bottomup || mf >= PBFSMINEDGES) {
+			for(k=0; k<numThreads; k++) {
+				for(i=0; i<args[k].num; i++)
+					S.order[cnt++] = G->arr[args[k].buf[i]];
+				args[k].num = 0;
+			}
+		}
+
+		for(p = S.fend; p < cnt; p++)
+			mu -= S.deg[S.order[p]->id];
+		S.fstart = S.fend;
+		S.fend = cnt;
+		S.d++;
+	}
+
+	/* heights, degrees and markers like bfsorder() */
+	for(i=0; i<n; i++) {
+		u = G->arr[i];
+		u->x = (atomic_load_explicit(&S.level[i], memory_order_relaxed) == PBFSUNSET);
+		if(setheight && !u->x) u->height = atomic_load_explicit(&S.level[i], memory_order_relaxed);
+		if(setdeg) u->deg = u->x ? 0 : S.deg[i];
+	}
+	if(S.fend < n) G->disconnected = 1;
+
+	for(k=0; k<numThreads; k++)
+		if(args[k].buf != NULL) free(args[k].buf);
+	free(args);
+	free((void *) S.level);
+	free((void *) S.claim);
+	free(S.deg);
+	if(S.roff != NULL) free(S.roff);
+	if(S.radj != NULL) free(S.radj);
+
+	return S.order;
+}
+
+
+// checks the heights and degrees set by parbfsorder() of G from root against
+// bfsdist() and that the order lists every vertex level by level, returns 1
+// if they agree
+int unit_test_parbfsroot(struct graph *G, INT root, INT numThreads) {
+	struct vertex **order, **queue;
+	struct list *li;
+	INT *dist, *seen, i, d;
+	int ok;
+
+	dist = (INT *) malloc(G->num * sizeof(INT));
+	seen = (INT *) calloc(G->num, sizeof(INT));
+	queue = (struct vertex **) malloc(G->num * sizeof(struct vertex *));
+	if(dist == NULL || seen == NULL || queue == NULL) {
+		fprintf(stderr, "Memory allocation error in function unit_test_parbfsroot.\n");
+		exit(-1);
+	}
+
+	order = parbfsorder(G, G->arr[root], 1, 1, numThreads);
+	ok = (bfsdist(G, G->arr[root], dist, queue) == G->num && !G->disconnected);
+	for(i=0; i<G->num; i++) {
+		for(d=0, li = G->arr[i]->qu->li; li != NULL; li = li->ne, d++);
+		if(G->arr[i]->height != dist[i] || G->arr[i]->deg != d) ok = 0;
+		seen[order[i]->id]++;
+		if(i > 0 && order[i]->height < order[i-1]->height) ok = 0;
+	}
+	for(i=0; i<G->num; i++)
+		if(seen[i] != 1) ok = 0;
+
+	free(order);
+	free(dist);
+	free(seen);
+	free(queue);
+
+	return ok;
+}
+
+
+// unit test for the functions of this header file
+int unit_test_parbfs() {
+	struct graph *G;
+	INT n, i, j, k;
+	int ok, fail;
+
+	fail = 0;
+	n = 2 * PBFSMINVERTICES;
+
+	// a random tree with random extra edges has a small diameter and its
+	// middle levels are expanded bottom-up
+	G = unit_test_tree(n);
+	for(k=0; k<4*n; k++) {
+		i = (INT) rand() % n;
+		j = (INT) rand() % n;
+		if(i != j) addEdge(G->arr[i], G->arr[j]);
+	}
+	ok = unit_test_parbfsroot(G, 0, 4) && unit_test_parbfsroot(G, n - 1, 2);
+	free_graph(G);
+	fail += unit_test_check(ok, "parbfsorder of a random graph");
+
+	// a grid has a large diameter and small levels
+	G = newgraph(n);
+	for(i=0; i<n; i++) {
+		if(i % 256 < 255) addEdge(G->arr[i], G->arr[i+1]);
+		if(i + 256 < n) addEdge(G->arr[i], G->arr[i+256]);
+	}
+	ok = unit_test_parbfsroot(G, 0, 4) && unit_test_parbfsroot(G, n / 2 + 128, 3);
+	free_graph(G);
+	fail += unit_test_check(ok, "parbfsorder of a grid");
+
+	return fail;
+}
@@ -0,0 +1,339 @@
+/*
+ *	We renumber the vertices of a graph to improve the cache locality of
+ *  traversal-heavy algorithms
+ *
+ *  The BFS loop in centrality() accesses its helper arrays via the ids of
+ *  the neighbours of the current vertex. If these ids are scattered over
+ *  the whole range, almost every access is a cache miss as soon as the
+ *  graph no longer fits into the last-level cache. Renumbering the vertices
+ *  such that adjacent vertices receive nearby ids avoids this.
+ *
+ *  Usage:
+ *		ord = reordergraph(G, root, method);
+ *		... run traversals ...
+ *		undoreorder(G, ord);
+ *
+ */
+
+
+#define REORDER_NONE 0		// keep the original vertex ids
+#define REORDER_BFS 1		// breadth-first-search order
+#define REORDER_RCM 2		// reverse Cuthill-McKee order
+#define REORDER_DEG 3		// vertices sorted by decreasing degree
+
+
+// pair of degree and vertex id, used for sorting neighbours
+struct degid {
+	INT deg;
+	INT id;
+};
+
+int cmpdegid(const void *a, const void *b) {
+	const struct degid *x = (const struct degid *) a;
+	const struct degid *y = (const struct degid *) b;
+
+	if(x->deg != y->deg) return (x->deg < y->deg) ? -1 : 1;
+	if(x->id != y->id) return (x->id < y->id) ? -1 : 1;
+	return 0;
+}
+
+
+// number of entries in the neighbourhood list of each vertex
+INT *listdegrees(struct graph *G) {
+	INT *deg, i;
+	struct list *li;
+
+	deg = (INT *) calloc(G->num, sizeof(INT));
+	if(deg == NULL) {
+		fprintf(stderr, "Memory allocation error in function listdegrees.\n");
+		exit(-1);
+	}
+
+	for(i=0; i<G->num; i++)
+		for(li = G->arr[i]->qu->li; li != NULL; li = li->ne)
+			deg[i]++;
+
+	return deg;
+}
+
+
+/*
+ * Breadth-first-search from the vertex with id start that records the level
+ * of each reached vertex. Only vertices with level[id] == unset are visited.
+ * Vertices are written to queue, the number of reached vertices is returned.
+ */
+INT levelbfs(struct graph *G, INT start, INT *level, INT unset, struct vertex **queue) {
+	INT j, pop;
+	struct list *li;
+
+	queue[0] = G->arr[start];
+	level[start] = 0;
+	for(j=0, pop=1; j<pop; j++) {
+		for(li = queue[j]->qu->li; li != NULL; li = li->ne) {
+			if(level[li->ve->id] == unset) {
+				level[li->ve->id] = level[queue[j]->id] + 1;
+				queue[pop] = li->ve;
+				pop++;
+			}
+		}
+	}
+
+	return pop;
+}
+
+
+/*
+ * Finds a pseudo-peripheral vertex in the connected component of start
+ * using the heuristic of Gibbs, Poole and Stockmeyer. Vertices in other
+ * components must not have level[id] == unset.
+ */
+INT peripheral(struct graph *G, INT start, INT *deg, INT *level, INT unset, struct vertex **queue) {
+	INT v, w, j, cnt, ecc, oldecc;
+
+	v = start;
+	oldecc = 0;
+	while(1) {
+		cnt = levelbfs(G, v, level, unset, queue);
+		ecc = level[queue[cnt-1]->id];
+
+		// among the vertices in the last level pick one of minimal degree
+		w = queue[cnt-1]->id;
+		for(j=cnt; j > 0 && level[queue[j-1]->id] == ecc; j--)
+			if(deg[queue[j-1]->id] < deg[w]) w = queue[j-1]->id;
+
+		// reset levels of the component
+		for(j=0; j<cnt; j++)
+			level[queue[j]->id] = unset;
+
+		if(ecc <= oldecc) break;
+		oldecc = ecc;
+		v = w;
+	}
+
+	return v;
+}
+
+
+/*
+ * Calculates the new vertex order. The returned array ord has length G->num,
+ * ord[k] is the (old) id of the vertex that receives the new id k.
+ */
+INT *reorderperm(struct graph *G, struct vertex *root, int method) {
+	INT *ord, *deg, *level, *cnt;
+	INT i, j, k, l, pos, num, start, unset;
+	struct vertex **queue;
+	struct degid *nb;
+	struct list *li;
+
+	num = G->num;
+	unset = num;	// no level can be as large as the number of vertices
+
+	ord = (INT *) calloc(num, sizeof(INT));
+	if(ord == NULL) {
+		fprintf(stderr, "Memory allocation error in function reorderperm.\n");
+		exit(-1);
+	}
+
+	deg = listdegrees(G);
+
+	if(method == REORDER_DEG) {
+		// counting sort by decreasing degree, ties broken by the old id
+		cnt = (INT *) calloc(num + 1, sizeof(INT));
+		if(cnt == NULL) {
+			fprintf(stderr, "Memory allocation error in function reorderperm.\n");
+			exit(-1);
+		}
+		for(i=0; i<num; i++)
+			cnt[ (deg[i] < num) ? num - 1 - deg[i] : 0 ]++;
+		for(i=0, pos=0; i<=num; i++) {
+			k = cnt[i];
+			cnt[i] = pos;
+			pos += k;
+		}
+		for(i=0; i<num; i++)
+			ord[ cnt[ (deg[i] < num) ? num - 1 - deg[i] : 0 ]++ ] = i;
+
+		free(cnt);
+		free(deg);
+		return ord;
+	}
+
+	level = (INT *) calloc(num, sizeof(INT));
+	queue = (struct vertex **) calloc(num, sizeof(struct vertex *));
+	if(level == NULL || queue == NULL) {
+		fprintf(stderr, "Memory allocation error in function reorderperm.\n");
+		exit(-1);
+	}
+	for(i=0; i<num; i++)
+		level[i] = unset;
+
+	nb = NULL;
+	if(method == REORDER_RCM) {
+		nb = (struct degid *) calloc(num, sizeof(struct degid));
+		if(nb == NULL) {
+			fprintf(stderr, "Memory allocation error in function reorderperm.\n");
+			exit(-1);
+		}
+	}
+
+	// process the connected components one after another
+	// the component of the root comes first
+	for(i=0, pos=0; i <= num && pos < num; i++) {
+		if(i == 0) {
+			start = (root != NULL) ? root->id : 0;
+		} else {
+			start = i - 1;
+		}
+		if(level[start] != unset) continue;
+
+		if(method == REORDER_RCM)
+			start = peripheral(G, start, deg, level, unset, queue);
+
+		// breadth-first search, levels only serve as visited markers here
+		ord[pos] = start;
+		level[start] = 0;
+		for(j=pos, pos++; j<pos; j++) {
+			for(k=0, li = G->arr[ord[j]]->qu->li; li != NULL; li = li->ne) {
+				if(level[li->ve->id] == unset) {
+					level[li->ve->id] = 0;
+					if(method == REORDER_RCM) {
+						// sort these neighbours by degree before queueing
+						nb[k].deg = deg[li->ve->id];
+						nb[k].id = li->ve->id;
+						k++;
+					} else {
+						ord[pos] = li->ve->id;
+						pos++;
+					}
+				}
+			}
+			if(method == REORDER_RCM) {
+				qsort(nb, k, sizeof(struct degid), cmpdegid);
+				for(l=0; l<k; l++, pos++)
+					ord[pos] = nb[l].id;
+			}
+		}
+	}
+
+	// reverse Cuthill-McKee: reverse the Cuthill-McKee order
+	if(method == REORDER_RCM) {
+		for(i=0; i < num/2; i++) {
+			k = ord[i];
+			ord[i] = ord[num-1-i];
+			ord[num-1-i] = k;
+		}
+	}
+
+	if(nb != NULL) free(nb);
+	free(queue);
+	free(level);
+	free(deg);
+
+	return ord;
+}
+
+
+/*
+ * Renumbers the vertices of G according to method. Returns the array ord
+ * from reorderperm(), which is needed to restore the original ids with
+ * undoreorder(). Pointer arrays like G->bfs and G->dfs remain valid.
+ */
+INT *reordergraph(struct graph *G, struct vertex *root, int method) {
+	INT *ord, i;
+	struct vertex **arr;
+
+	/* sanity checks */
+	if(G == NULL || G->num < 1 || method == REORDER_NONE) return NULL;
+
+	ord = reorderperm(G, root, method);
+
+	arr = (struct vertex **) calloc(G->num, sizeof(struct vertex *));
+	if(arr == NULL) {
+		fprintf(stderr, "Memory allocation error in function reordergraph.\n");
+		exit(-1);
+	}
+
+	for(i=0; i<G->num; i++) {
+		arr[i] = G->arr[ord[i]];
+		arr[i]->id = i;
+	}
+
+	free(G->arr);
+	G->arr = arr;
+
+	return ord;
+}
+
+
+/*
+ * Restores the vertex ids that G had before the call ord = reordergraph(...)
+ * and frees ord
+ */
+void undoreorder(struct graph *G, INT *ord) {
+	INT i;
+	struct vertex **arr;
+
+	if(G == NULL || ord == NULL) return;
+
+	arr = (struct vertex **) calloc(G->num, sizeof(struct vertex *));
+	if(arr == NULL) {
+		fprintf(stderr, "Memory allocation error in function undoreorder.\n");
+		exit(-1);
+	}
+
+	for(i=0; i<G->num; i++) {
+		arr[ord[i]] = G->arr[i];
+		arr[ord[i]]->id = ord[i];
+	}
+
+	free(G->arr);
+	G->arr = arr;
+
+	free(ord);
+}
+
+
+/*
+ * Restores the original order of an array with num entries of the given
+ * width that was indexed by the new vertex ids. Needs to be called before
+ * undoreorder(G, ord).
+ */
+void unpermute(void *data, size_t width, INT num, INT *ord) {
+	char *tmp;
+	INT i;
+
+	if(data == NULL || ord == NULL) return;
+
+	tmp = (char *) malloc(num * width);
+	if(tmp == NULL) {
+		fprintf(stderr, "Memory allocation error in function unpermute.\n");
+		exit(-1);
+	}
+
+	for(i=0; i<num; i++)
+		memcpy(tmp + ord[i] * width, (char *) data + i * width, width);
+	memcpy(data, tmp, num * width);
+
+	free(tmp);
+}
+
+
+/*
+ * Returns a newly allocated array with the vertices of G in the order before
+ * the call ord = reordergraph(...). If ord is NULL, this is a copy of G->arr.
+ */
+struct vertex **origorder(struct graph *G, INT *ord) {
+	struct vertex **arr;
+	INT i;
+
+	arr = (struct vertex **) calloc(G->num, sizeof(struct vertex *));
+	if(arr == NULL) {
+		fprintf(stderr, "Memory allocation error in function origorder.\n");
+		exit(-1);
+	}
+
+	for(i=0; i<G->num; i++)
+		arr[(ord != NULL) ? ord[i] : i] = G->arr[i];
+
+	return arr;
+}
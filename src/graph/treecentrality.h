@@ -0,0 +1,516 @@
+/*
+ *	Linear time algorithms for centrality measures of trees
+ *
+ *  The vertices of the tree are passed as an array dfs in depth-first-search
+ *  order, starting with the root. For the trees generated by deg2dfstree()
+ *  this is simply G->arr.
+ *
+ */
+
+
+/*
+ * Calculates the parent of each vertex. In depth-first-search order the
+ * parent of a vertex is its only neighbour that precedes it. Returns an
+ * array par with par[id] = id of the parent and par[root id] = G->num.
+ */
+INT *treeparents(struct graph *G, struct vertex **dfs) {
+	INT *par, *pos, i;
+	struct list *li;
+
+	par = (INT *) calloc(G->num, sizeof(INT));
+	pos = (INT *) calloc(G->num, sizeof(INT));
+	if(par == NULL || pos == NULL) {
+		fprintf(stderr, "Memory allocation error in function treeparents.\n");
+		exit(-1);
+	}
+
+	for(i=0; i<G->num; i++)
+		pos[dfs[i]->id] = i;
+
+	for(i=0; i<G->num; i++) {
+		par[dfs[i]->id] = G->num;
+		for(li = dfs[i]->qu->li; li != NULL; li = li->ne) {
+			if(pos[li->ve->id] < i) {
+				par[dfs[i]->id] = li->ve->id;
+				break;
+			}
+		}
+	}
+
+	free(pos);
+	return par;
+}
+
+
+/*
+ * Calculates the number of vertices in the fringe subtree of each vertex
+ */
+INT *subtreesizes(struct graph *G, struct vertex **dfs, INT *par) {
+	INT *size, i, v;
+
+	size = (INT *) calloc(G->num, sizeof(INT));
+	if(size == NULL) {
+		fprintf(stderr, "Memory allocation error in function subtreesizes.\n");
+		exit(-1);
+	}
+
+	// children come after their parent in depth-first-search order
+	for(i=G->num; i > 0; i--) {
+		v = dfs[i-1]->id;
+		size[v] += 1;
+		if(par[v] < G->num) size[par[v]] += size[v];
+	}
+
+	return size;
+}
+
+
+/*
+ * Calculates the betweenness centrality of the vertices of a tree
+ *
+ * Removing a vertex v splits the tree into the fringe subtrees of its
+ * children and the rest. The number of pairs of vertices that are connected
+ * through v is the number of pairs from distinct components:
+ *		( (n-1)^2 - sum of squared component sizes ) / 2
+ */
+DOUBLE *treebetweenness(struct graph *G, struct vertex **dfs) {
+	INT *par, *size, i, n;
+	INTD *sq;
+	DOUBLE *btw;
+
+	n = G->num;
+	par = treeparents(G, dfs);
+	size = subtreesizes(G, dfs, par);
+
+	btw = (DOUBLE *) calloc(n, sizeof(DOUBLE));
+	sq = (INTD *) calloc(n, sizeof(INTD));
+	if(btw == NULL || sq == NULL) {
+		fprintf(stderr, "Memory allocation error in function treebetweenness.\n");
+		exit(-1);
+	}
+
+	// sum of squared component sizes of the tree without vertex i
+	for(i=0; i<n; i++) {
+		sq[i] += (INTD) (n - size[i]) * (INTD) (n - size[i]);
+		if(par[i] < n) sq[par[i]] += (INTD) size[i] * (INTD) size[i];
+	}
+
+	for(i=0; i<n; i++)
+		btw[i] = (DOUBLE) ( (INTD) (n-1) * (INTD) (n-1) - sq[i] ) / 2.0;
+
+	free(sq);
+	free(size);
+	free(par);
+
+	return btw;
+}
+
+
+/*
+ * Calculates the eccentricity of the vertices of a tree
+ *
+ * If a and b are the end points of a longest path, then the eccentricity of
+ * any vertex v is max(d(v,a), d(v,b)). We find a as the vertex farthest away
+ * from the root and b as the vertex farthest away from a.
+ */
+INT *treeeccentricity(struct graph *G, struct vertex *root) {
+	INT *ecc, *dist, i, cnt;
+	struct vertex **queue;
+	struct vertex *a, *b;
+
+	ecc = (INT *) calloc(G->num, sizeof(INT));
+	dist = (INT *) calloc(G->num, sizeof(INT));
+	queue = (struct vertex **) calloc(G->num, sizeof(struct vertex *));
+	if(ecc == NULL || dist == NULL || queue == NULL) {
+		fprintf(stderr, "Memory allocation error in function treeeccentricity.\n");
+		exit(-1);
+	}
+
+	// the last vertex in bfs order is farthest away from the source
+	cnt = bfsdist(G, root, dist, queue);
+	a = queue[cnt-1];
+
+	cnt = bfsdist(G, a, ecc, queue);
+	b = queue[cnt-1];
+
+	bfsdist(G, b, dist, queue);
+	for(i=0; i<G->num; i++)
+		if(dist[i] > ecc[i]) ecc[i] = dist[i];
+
+	free(dist);
+	free(queue);
+
+	return ecc;
+}
+
+
+/*
+ * Checks in linear time whether the connected graph G is a tree whose
+ * neighbourhood lists contain every edge in both directions. The heights
+ * have to be set by bfsorder(). In a tree, every vertex but the root has
+ * exactly one neighbour one level up, its parent, all other neighbours are
+ * one level down and list it as their parent. Returns the array of parents
+ * like treeparents(), or NULL if G is no tree.
+ */
+INT *treecheck(struct graph *G, struct vertex *root) {
+	INT *par, i, n, m;
+	struct vertex *v;
+	struct list *li;
+
+	n = G->num;
+	if(G->disconnected || n == 0) return NULL;
+
+	// a tree has n-1 edges, each of them is listed twice
+	for(m=0, i=0; i<n; i++) {
+		for(li = G->arr[i]->qu->li; li != NULL; li = li->ne) {
+			if(++m > 2 * (n - 1)) return NULL;
+		}
+	}
+	if(m != 2 * (n - 1)) return NULL;
+
+	par = (INT *) malloc(n * sizeof(INT));
+	if(par == NULL) {
+		fprintf(stderr, "Memory allocation error in function treecheck.\n");
+		exit(-1);
+	}
+	for(i=0; i<n; i++)
+		par[i] = n;
+
+	for(i=0; i<n; i++) {
+		v = G->arr[i];
+		for(li = v->qu->li; li != NULL; li = li->ne) {
+			if(li->ve->height + 1 == v->height && par[v->id] == n) {
+				par[v->id] = li->ve->id;
+			} else if(li->ve->height != v->height + 1) {
+				free(par);
+				return NULL;
+			}
+		}
+		if(par[v->id] == n && v != root) {
+			free(par);
+			return NULL;
+		}
+	}
+
+	// the children have to agree
+	for(i=0; i<n; i++) {
+		v = G->arr[i];
+		for(li = v->qu->li; li != NULL; li = li->ne) {
+			if(li->ve->height == v->height + 1 && par[li->ve->id] != v->id) {
+				free(par);
+				return NULL;
+			}
+		}
+	}
+
+	return par;
+}
+
+
+/*
+ * Calculates the sum of the distances from every vertex of a tree to all
+ * other vertices and stores it in the cent field. The sum of the root is the
+ * sum of the heights. Moving from a vertex to its child v brings the size[v]
+ * vertices of the fringe subtree of v one step closer and all others one step
+ * farther away.
+ */
+void treecloseness(struct graph *G, struct vertex **dfs, INT *par) {
+	INT *size, i, n;
+	INTD sum;
+	struct vertex *v;
+
+	n = G->num;
+	size = subtreesizes(G, dfs, par);
+
+	for(sum=0, i=0; i<n; i++)
+		sum += dfs[i]->height;
+	dfs[0]->cent = sum;
+
+	// parents come before their children
+	for(i=1; i<n; i++) {
+		v = dfs[i];
+		v->cent = G->arr[par[v->id]]->cent + (INTD) n - 2 * (INTD) size[v->id];
+	}
+
+	free(size);
+}
+
+
+/*
+ * Looptree statistics without building the looptree
+ *
+ * In the looptree L(T) every vertex v and its children, in the order of the
+ * list of v, form a cycle (a single edge if v has one child). The cycles
+ * meet in the vertices only, so a shortest path in L(T) follows the path in
+ * T and takes the shorter way around every cycle it passes. The distance on
+ * the cycle of v between the positions a and b (v itself at position 0) is
+ * min(|a-b|, len - |a-b|), where len is the number of children plus one.
+ */
+
+
+/*
+ * Sets pos[c] to the position of every child c on the cycle of its parent
+ * (1, 2, ... in the order of the list of the parent, 0 for the root) and
+ * len[v] to the length of the cycle of v
+ */
+void loopcycles(struct graph *G, INT *par, INT *pos, INT *len) {
+	INT i;
+	struct list *li;
+
+	for(i=0; i<G->num; i++)
+		pos[i] = 0;
+	for(i=0; i<G->num; i++) {
+		len[i] = 1;
+		for(li = G->arr[i]->qu->li; li != NULL; li = li->ne) {
+			if(li->ve->id != par[i]) pos[li->ve->id] = len[i]++;
+		}
+	}
+}
+
+
+// distance between the positions a and b on a cycle of length len
+INT cycdist(INT a, INT b, INT len) {
+	INT d;
+
+	d = (a > b) ? a - b : b - a;
+	return (d < len - d) ? d : len - d;
+}
+
+
+/*
+ * Calculates the heights of the vertices in the looptree, their distances
+ * from the root. The parents par have to precede their children in order.
+ */
+INT *loopheights(struct graph *G, struct vertex **order, INT *par) {
+	INT *hei, *pos, *len, i, v;
+
+	hei = (INT *) malloc(G->num * sizeof(INT));
+	pos = (INT *) malloc(G->num * sizeof(INT));
+	len = (INT *) malloc(G->num * sizeof(INT));
+	if(hei == NULL || pos == NULL || len == NULL) {
+		fprintf(stderr, "Memory allocation error in function loopheights.\n");
+		exit(-1);
+	}
+	loopcycles(G, par, pos, len);
+
+	for(i=0; i<G->num; i++) {
+		v = order[i]->id;
+		hei[v] = (par[v] < G->num) ? hei[par[v]] + cycdist(0, pos[v], len[par[v]]) : 0;
+	}
+
+	free(pos);
+	free(len);
+
+	return hei;
+}
+
+
+/*
+ * Sums of the cycle distances from every position of a cycle of length m
+ * with weights w: f[i] = sum of w[j] * cycdist(i, j, m). The positions j at
+ * distance 1, ..., m/2 in one direction and 1, ..., (m-1)/2 in the other
+ * form two windows, whose sums follow from the prefix sums P of the weights
+ * and Q of the weighted positions along three rounds of the cycle. P and Q
+ * need room for 3m+1 entries.
+ */
+void cyclesums(INT m, INTD *w, INTD *f, INTD *P, INTD *Q) {
+	INT i, s, h, c;
+
+	h = m / 2;
+	c = m - 1 - h;
+	P[0] = 0;
+	Q[0] = 0;
+	for(i=0; i<3*m; i++) {
+		P[i+1] = P[i] + w[i % m];
+		Q[i+1] = Q[i] + (INTD) i * w[i % m];
+	}
+
+	// position i is s in the second round
+	for(i=0; i<m; i++) {
+		s = i + m;
+		f[i] = (Q[s+h+1] - Q[s+1]) - (INTD) s * (P[s+h+1] - P[s+1])
+			+ (INTD) s * (P[s] - P[s-c]) - (Q[s] - Q[s-c]);
+	}
+}
+
+
+/*
+ * Calculates the closeness centrality of the vertices in the looptree,
+ * (n-1) divided by the sum of the distances to all other vertices, in
+ * linear time. The parents par have to precede their children in order.
+ *
+ * down[v] is the sum of the distances from v to the vertices of its fringe
+ * subtree. The sum for a child c of v adds the distances to the vertices
+ * that are reached through the other positions on the cycle of v: position
+ * 0 stands for v and all vertices outside its fringe subtree, position j for
+ * the fringe subtree of the j-th child.
+ */
+DOUBLE *loopcloseness(struct graph *G, struct vertex **order, INT *par) {
+	INT *size, *pos, *len, i, n, v, m;
+	INTD *down, *sum, *w, *f, *P, *Q, base;
+	DOUBLE *clo;
+	struct list *li;
+
+	n = G->num;
+	size = subtreesizes(G, order, par);
+	pos = (INT *) malloc(n * sizeof(INT));
+	len = (INT *) malloc(n * sizeof(INT));
+	down = (INTD *) calloc(n, sizeof(INTD));
+	sum = (INTD *) malloc(n * sizeof(INTD));
+	clo = (DOUBLE *) malloc(n * sizeof(DOUBLE));
+	if(pos == NULL || len == NULL || down == NULL || sum == NULL || clo == NULL) {
+		fprintf(stderr, "Memory allocation error in function loopcloseness.\n");
+		exit(-1);
+	}
+	loopcycles(G, par, pos, len);
+
+	// the longest cycle
+	for(m=1, i=0; i<n; i++)
+		if(len[i] > m) m = len[i];
+	w = (INTD *) malloc(m * sizeof(INTD));
+	f = (INTD *) malloc(m * sizeof(INTD));
+	P = (INTD *) malloc((3 * m + 1) * sizeof(INTD));
+	Q = (INTD *) malloc((3 * m + 1) * sizeof(INTD));
+	if(w == NULL || f == NULL || P == NULL || Q == NULL) {
+		fprintf(stderr, "Memory allocation error in function loopcloseness.\n");
+		exit(-1);
+	}
+
+	// children come after their parent in order
+	for(i=n; i > 0; i--) {
+		v = order[i-1]->id;
+		if(par[v] < n) down[par[v]] += down[v] + (INTD) size[v] * cycdist(0, pos[v], len[par[v]]);
+	}
+
+	// parents come before their children
+	sum[order[0]->id] = down[order[0]->id];
+	for(i=0; i<n; i++) {
+		v = order[i]->id;
+		if(len[v] < 2) continue;
+
+		w[0] = n - size[v] + 1;
+		base = sum[v] - down[v];
+		for(li = G->arr[v]->qu->li; li != NULL; li = li->ne) {
+			if(li->ve->id == par[v]) continue;
+			w[pos[li->ve->id]] = size[li->ve->id];
+			base += down[li->ve->id];
+		}
+		cyclesums(len[v], w, f, P, Q);
+		for(li = G->arr[v]->qu->li; li != NULL; li = li->ne) {
+			if(li->ve->id != par[v]) sum[li->ve->id] = base + f[pos[li->ve->id]];
+		}
+	}
+
+	// the same numbers as outcent()
+	for(i=0; i<n; i++)
+		clo[i] = (DOUBLE) ((double) (n - 1) / (double) sum[i]);
+
+	free(size);
+	free(pos);
+	free(len);
+	free(down);
+	free(sum);
+	free(w);
+	free(f);
+	free(P);
+	free(Q);
+
+	return clo;
+}
+
+
+// compares loopheights() and loopcloseness() of G from root with breadth-first
+// searches in the looptree built by looptree(), returns 1 if they agree
+int unit_test_looproot(struct graph *G, INT root) {
+	struct graph *H;
+	struct vertex **queue;
+	struct list *li;
+	INT *dist, *par, *hei, i, j, n;
+	INTD sum;
+	DOUBLE *clo;
+	int ok;
+
+	n = G->num;
+	dist = (INT *) malloc(n * sizeof(INT));
+	par = (INT *) malloc(n * sizeof(INT));
+	queue = (struct vertex **) malloc(n * sizeof(struct vertex *));
+	if(dist == NULL || par == NULL || queue == NULL) {
+		fprintf(stderr, "Memory allocation error in function unit_test_looproot.\n");
+		exit(-1);
+	}
+
+	// parents as in analyseroot(), the queue holds the bfs order
+	bfsdist(G, G->arr[root], dist, queue);
+	for(i=0; i<n; i++) {
+		par[i] = n;
+		for(li = G->arr[i]->qu->li; li != NULL && dist[li->ve->id] + 1 != dist[i]; li = li->ne);
+		if(li != NULL) par[i] = li->ve->id;
+	}
+	hei = loopheights(G, queue, par);
+	clo = (n > 1) ? loopcloseness(G, queue, par) : NULL;
+
+	H = looptree(G, G->arr[root]);
+	bfsdist(H, H->arr[root], dist, queue);
+	for(ok=1, i=0; i<n; i++)
+		if(hei[i] != dist[i]) ok = 0;
+	for(i=0; n > 1 && i<n; i++) {
+		bfsdist(H, H->arr[i], dist, queue);
+		for(sum=0, j=0; j<n; j++)
+			sum += dist[j];
+		if(clo[i] != (DOUBLE) ((double) (n - 1) / (double) sum)) ok = 0;
+	}
+
+	free_graph(H);
+	free(dist);
+	free(par);
+	free(queue);
+	free(hei);
+	if(clo != NULL) free(clo);
+
+	return ok;
+}
+
+
+// unit test for the looptree functions of this header file
+int unit_test_looptree() {
+	struct graph *G;
+	INTD w[17], f[17], P[52], Q[52], s;
+	INT m, i, j, k, n;
+	int ok, fail;
+
+	fail = 0;
+
+	// cycles of odd and even length against the sums over all positions
+	for(ok=1, m=1; m<=17; m++) {
+		for(i=0; i<m; i++)
+			w[i] = rand() % 100;
+		cyclesums(m, w, f, P, Q);
+		for(i=0; i<m; i++) {
+			for(s=0, j=0; j<m; j++)
+				s += w[j] * cycdist(i, j, m);
+			if(f[i] != s) ok = 0;
+		}
+	}
+	fail += unit_test_check(ok, "cyclesums");
+
+	// stars give a single cycle of length k+1 from the centre and k from a
+	// leaf
+	for(ok=1, k=1; k<=8; k++) {
+		G = newgraph(k + 1);
+		for(i=1; i<=k; i++)
+			addEdge(G->arr[0], G->arr[i]);
+		if(!unit_test_looproot(G, 0) || !unit_test_looproot(G, 1)) ok = 0;
+		free_graph(G);
+	}
+	fail += unit_test_check(ok, "looptree of stars");
+
+	// small random trees from several roots
+	for(ok=1, n=1; n<=60; n += 1 + n / 4) {
+		G = unit_test_tree(n);
+		if(!unit_test_looproot(G, 0) || !unit_test_looproot(G, n / 2) || !unit_test_looproot(G, n - 1)) ok = 0;
+		free_graph(G);
+	}
+	fail += unit_test_check(ok, "looptree of random trees");
+
+	return fail;
+}
@@ -0,0 +1,303 @@
+/*
+ *	Distance distribution and Wiener index of a tree
+ *
+ *  Wiener index: removing the edge between v and its parent splits the tree
+ *  into the fringe subtree of v and the rest. Every pair of vertices from
+ *  different sides has a path through this edge, hence the sum of all
+ *  distances is the sum of size(v) * (n - size(v)) over all non-root v.
+ *
+ *  Distance distribution: we use a centroid decomposition. If c is a
+ *  centroid of a component and cnt[d] is the number of vertices at depth d
+ *  below c, then the convolution cnt * cnt counts the pairs of vertices by
+ *  the length of their path through c. Pairs inside the same branch of c
+ *  are removed by subtracting the convolution of the branch with itself.
+ *  Afterwards c is deleted and the branches are processed recursively.
+ *  The convolutions are calculated exactly by number theoretic transforms
+ *  modulo three primes and the chinese remainder theorem, which takes
+ *  O(n log^2 n) time overall.
+ */
+
+
+// primes p = c * 2^k + 1 with k >= 26 and primitive roots modulo p
+#define NTTPRIMES 3
+#define NTTMAXLEN (1UL << 26)
+const unsigned long long nttprime[NTTPRIMES] = {469762049ULL, 1811939329ULL, 2013265921ULL};
+const unsigned long long nttroot[NTTPRIMES] = {3ULL, 13ULL, 31ULL};
+
+// below this length the convolution is calculated directly
+#define NAIVECONV 64
+
+
+// b^e modulo p
+unsigned long long powmod(unsigned long long b, unsigned long long e, unsigned long long p) {
+	unsigned long long r = 1;
+
+	b %= p;
+	while(e > 0) {
+		if(e & 1) r = r * b % p;
+		b = b * b % p;
+		e >>= 1;
+	}
+
+	return r;
+}
+
+
+/*
+ * In-place number theoretic transform of a (length len, a power of two)
+ * modulo the prime p with primitive root g. If inverse != 0 the inverse
+ * transform is calculated.
+ */
+void ntt(unsigned long long *a, INT len, unsigned long long p, unsigned long long g, int inverse) {
+	INT i, j, k, m;
+	unsigned long long w, wm, u, t;
+
+	// bit reversal permutation
+	for(i=1, j=0; i<len; i++) {
+		for(k = len >> 1; j & k; k >>= 1)
+			j ^= k;
+		j ^= k;
+		if(i < j) {
+			t = a[i];
+			a[i] = a[j];
+			a[j] = t;
+		}
+	}
+
+	for(m=2; m<=len; m <<= 1) {
+		wm = powmod(g, (p-1) / m, p);
+		if(inverse) wm = powmod(wm, p-2, p);
+		for(i=0; i<len; i += m) {
+			w = 1;
+			for(j=0; j < m/2; j++) {
+				u = a[i+j];
+				t = a[i+j+m/2] * w % p;
+				a[i+j] = (u + t) % p;
+				a[i+j+m/2] = (u + p - t) % p;
+				w = w * wm % p;
+			}
+		}
+	}
+
+	if(inverse) {
+		t = powmod(len, p-2, p);
+		for(i=0; i<len; i++)
+			a[i] = a[i] * t % p;
+	}
+}
+
+
+/*
+ * Calculates res[d] = sum_{i+j=d} cnt[i] * cnt[j] for d = 0, ..., 2*len-2
+ * The results need to be smaller than 2^64.
+ */
+void selfconvolution(INTD *cnt, INT len, INTD *res) {
+	unsigned long long *a[NTTPRIMES];
+	unsigned long long p1, p2, p3, x1, x2, x3, inv1, inv12;
+	INT i, j, L;
+	int k;
+
+	if(len == 0) return;
+
+	for(L=1; L < 2*len-1; L <<= 1);
+
+	// short sequences (and sequences that are too long for the primes)
+	if(len <= NAIVECONV || L > NTTMAXLEN) {
+		for(i=0; i < 2*len-1; i++)
+			res[i] = 0;
+		for(i=0; i<len; i++) {
+			if(cnt[i] == 0) continue;
+			for(j=0; j<len; j++)
+				res[i+j] += cnt[i] * cnt[j];
+		}
+		return;
+	}
+
+	for(k=0; k<NTTPRIMES; k++) {
+		a[k] = (unsigned long long *) calloc(L, sizeof(unsigned long long));
+		if(a[k] == NULL) {
+			fprintf(stderr, "Memory allocation error in function selfconvolution.\n");
+			exit(-1);
+		}
+		for(i=0; i<len; i++)
+			a[k][i] = cnt[i] % nttprime[k];
+		ntt(a[k], L, nttprime[k], nttroot[k], 0);
+		for(i=0; i<L; i++)
+			a[k][i] = a[k][i] * a[k][i] % nttprime[k];
+		ntt(a[k], L, nttprime[k], nttroot[k], 1);
+	}
+
+	// combine the residues (Garner's algorithm)
+	p1 = nttprime[0];
+	p2 = nttprime[1];
+	p3 = nttprime[2];
+	inv1 = powmod(p1, p2-2, p2);
+	inv12 = powmod(p1 * p2 % p3, p3-2, p3);
+	for(i=0; i < 2*len-1; i++) {
+		x1 = a[0][i];
+		x2 = (a[1][i] + p2 - x1 % p2) % p2 * inv1 % p2;
+		x3 = (a[2][i] + p3 - (x1 + x2 * p1) % p3) % p3 * inv12 % p3;
+		res[i] = (INTD) ( (unsigned __int128) x1 + (unsigned __int128) x2 * p1 + (unsigned __int128) x3 * p1 * p2 );
+	}
+
+	for(k=0; k<NTTPRIMES; k++)
+		free(a[k]);
+}
+
+
+/*
+ * Breadth-first search from r in the component of the tree that consists
+ * of the vertices with removed[id] == 0. The search does not go back to the
+ * vertex p, which is the parent of r (G->num if there is none). Stores
+ * parents and depths (starting with d) and returns the number of reached
+ * vertices.
+ */
+INT componentbfs(struct graph *G, struct vertex *r, INT p, INT d, char *removed, INT *par, INT *depth, struct vertex **queue) {
+	INT j, pop;
+	struct vertex *v;
+	struct list *li;
+
+	queue[0] = r;
+	par[r->id] = p;
+	depth[r->id] = d;
+	for(j=0, pop=1; j<pop; j++) {
+		v = queue[j];
+		for(li = v->qu->li; li != NULL; li = li->ne) {
+			if(li->ve->id == par[v->id] || removed[li->ve->id]) continue;
+			par[li->ve->id] = v->id;
+			depth[li->ve->id] = depth[v->id] + 1;
+			queue[pop] = li->ve;
+			pop++;
+		}
+	}
+
+	return pop;
+}
+
+
+/*
+ * Calculates the distance distribution of a tree. Returns an array hist with
+ * G->num entries, hist[d] is the number of unordered pairs of vertices at
+ * distance d (hist[0] = 0).
+ */
+INTD *treedistances(struct graph *G) {
+	INTD *hist, *cnt, *conv;
+	INT *par, *size, *depth, *stack;
+	INT n, i, top, cntv, maxd;
+	char *removed;
+	struct vertex **queue, *c, *w;
+	struct list *li;
+	int moved;
+
+	n = G->num;
+	hist = (INTD *) calloc(n, sizeof(INTD));
+	cnt = (INTD *) calloc(n + 1, sizeof(INTD));
+	conv = (INTD *) calloc(2*n + 1, sizeof(INTD));
+	par = (INT *) calloc(n, sizeof(INT));
+	size = (INT *) calloc(n, sizeof(INT));
+	depth = (INT *) calloc(n, sizeof(INT));
+	stack = (INT *) calloc(n, sizeof(INT));
+	removed = (char *) calloc(n, sizeof(char));
+	queue = (struct vertex **) calloc(n, sizeof(struct vertex *));
+	if(hist == NULL || cnt == NULL || conv == NULL || par == NULL || size == NULL || depth == NULL || stack == NULL || removed == NULL || queue == NULL) {
+		fprintf(stderr, "Memory allocation error in function treedistances.\n");
+		exit(-1);
+	}
+
+	// hist collects ordered pairs, the subtractions may wrap around
+	// temporarily but the final counts are exact
+	top = 0;
+	if(n > 0) stack[top++] = 0;
+	while(top > 0) {
+		/* find a centroid of the component of stack[top-1] */
+		cntv = componentbfs(G, G->arr[stack[--top]], n, 0, removed, par, depth, queue);
+		for(i=cntv; i > 0; i--) {
+			size[queue[i-1]->id] = 1;
+		}
+		for(i=cntv; i > 1; i--) {
+			size[par[queue[i-1]->id]] += size[queue[i-1]->id];
+		}
+
+		c = queue[0];
+		do {
+			moved = 0;
+			for(li = c->qu->li; li != NULL; li = li->ne) {
+				w = li->ve;
+				if(w->id != par[c->id] && !removed[w->id] && 2 * size[w->id] > cntv) {
+					c = w;
+					moved = 1;
+					break;
+				}
+			}
+		} while(moved);
+
+		/* pairs of vertices with a path through c */
+		cntv = componentbfs(G, c, n, 0, removed, par, depth, queue);
+		maxd = depth[queue[cntv-1]->id];
+		for(i=0; i<cntv; i++)
+			cnt[depth[queue[i]->id]]++;
+		selfconvolution(cnt, maxd + 1, conv);
+		for(i=1; i <= 2*maxd && i < n; i++)
+			hist[i] += conv[i];
+		for(i=0; i <= maxd; i++)
+			cnt[i] = 0;
+
+		removed[c->id] = 1;
+
+		/* minus the pairs within a single branch */
+		for(li = c->qu->li; li != NULL; li = li->ne) {
+			w = li->ve;
+			if(removed[w->id]) continue;
+
+			cntv = componentbfs(G, w, c->id, 1, removed, par, depth, queue);
+			maxd = depth[queue[cntv-1]->id];
+			for(i=0; i<cntv; i++)
+				cnt[depth[queue[i]->id]]++;
+			selfconvolution(cnt, maxd + 1, conv);
+			for(i=1; i <= 2*maxd && i < n; i++)
+				hist[i] -= conv[i];
+			for(i=0; i <= maxd; i++)
+				cnt[i] = 0;
+
+			// the branch is a component of its own now
+			if(cntv > 1) stack[top++] = w->id;
+		}
+	}
+
+	// every unordered pair was counted twice
+	for(i=1; i<n; i++)
+		hist[i] /= 2;
+
+	free(cnt);
+	free(conv);
+	free(par);
+	free(size);
+	free(depth);
+	free(stack);
+	free(removed);
+	free(queue);
+
+	return hist;
+}
+
+
+/*
+ * Calculates the Wiener index of a tree, the vertices are passed in
+ * depth-first-search order
+ */
+INTW treewiener(struct graph *G, struct vertex **dfs) {
+	INT *par, *size, i;
+	INTW w;
+
+	par = treeparents(G, dfs);
+	size = subtreesizes(G, dfs, par);
+
+	for(w=0, i=0; i<G->num; i++) {
+		if(par[i] < G->num) w += (INTW) size[i] * (INTW) (G->num - size[i]);
+	}
+
+	free(size);
+	free(par);
+
+	return w;
+}
@@ -0,0 +1,275 @@
+/*
+ * Balanced parentheses tree format (.bp)
+ *
+ * A rooted plane tree is determined by the sequence of parentheses that a
+ * depth-first search writes when it enters a vertex "(" and when it leaves
+ * it again ")". Trees written to a file whose name ends in .bp are stored
+ * this way with one bit per parenthesis, i.e. two bits per vertex. Such
+ * files are recognized by --inputfile.
+ *
+ *		char magic[8]			"GRANTBP1"
+ *		uint64 num				number of vertices
+ *		bits[(2*num + 7) / 8]	bit k of the sequence is bit k%8 of byte k/8,
+ *								1 for "(" and 0 for ")"
+ *
+ * The vertices are numbered in depth-first-search order starting with the
+ * root 0, the children of a vertex are visited in the order of its
+ * neighbourhood list. For the trees of gwtree() this is the order in which
+ * they are simulated, so reading the .bp file yields the same graph as
+ * reading the graphml file of the tree.
+ */
+
+
+#define BPMAGIC "GRANTBP1"
+
+
+// appends one parenthesis to the bits collected in cur, if there is a buffer
+void bpputbit(struct obuf *O, unsigned char *cur, int *nbits, int bit) {
+	if(O == NULL) return;
+	if(bit) *cur |= (unsigned char) (1 << *nbits);
+	(*nbits)++;
+	if(*nbits == 8) {
+		obwrite(O, (char *) cur, 1);
+		*cur = 0;
+		*nbits = 0;
+	}
+}
+
+
+/*
+ * Depth-first search from the root (or from the first vertex if there is
+ * none) that writes the parentheses to O, or only visits the vertices if O
+ * is NULL. Returns the number of visited vertices.
+ */
+INT bpdfs(struct graph *G, struct obuf *O) {
+	struct vertex *r, *w;
+	struct list **it;
+	INT top, cnt;
+	char *visited;
+	unsigned char cur;
+	int nbits;
+
+	it = (struct list **) malloc(G->num * sizeof(struct list *));
+	visited = (char *) calloc(G->num, sizeof(char));
+	if(it == NULL || visited == NULL) {
+		fprintf(stderr, "Memory allocation error in function bpdfs.\n");
+		exit(-1);
+	}
+
+	// it[k] is the next neighbour to try of the vertex at depth k
+	cur = 0;
+	nbits = 0;
+	r = (G->root != NULL) ? G->root : G->arr[0];
+	it[0] = r->qu->li;
+	visited[r->id] = 1;
+	top = 1;
+	cnt = 1;
+	bpputbit(O, &cur, &nbits, 1);
+	while(top > 0) {
+		while(it[top-1] != NULL && visited[it[top-1]->ve->id])
+			it[top-1] = it[top-1]->ne;
+
+		if(it[top-1] != NULL) {
+			w = it[top-1]->ve;
+			it[top-1] = it[top-1]->ne;
+			it[top] = w->qu->li;
+			visited[w->id] = 1;
+			top++;
+			cnt++;
+			bpputbit(O, &cur, &nbits, 1);
+		} else {
+			top--;
+			bpputbit(O, &cur, &nbits, 0);
+		}
+	}
+	if(O != NULL && nbits > 0) obwrite(O, (char *) &cur, 1);
+
+	free(it);
+	free(visited);
+
+	return cnt;
+}
+
+
+/*
+ * Exits if G is not a tree. Called before the output file is opened, so
+ * that nothing is written for a graph that cannot be stored as a .bp file.
+ */
+void bpcheck(struct graph *G) {
+	struct list *li;
+	INT cnt, i;
+
+	// a connected graph with num-1 (pairs of di-)edges is a tree
+	for(cnt=0, i=0; i<G->num; i++) {
+		for(li = G->arr[i]->qu->li; li != NULL; li = li->ne)
+			cnt++;
+	}
+	if(G->num == 0 || cnt != 2 * (G->num - 1) || bpdfs(G, NULL) != G->num) {
+		fprintf(stderr, "Error: the balanced parentheses format (.bp) is only available for trees.\n");
+		exit(-1);
+	}
+}
+
+
+/*
+ * Writes the tree G in the balanced parentheses format, starting at the
+ * root (or at the first vertex if there is none). G has to pass bpcheck().
+ */
+int writebp(struct graph *G, FILE *outstream) {
+	struct obuf O;
+	uint64_t num;
+
+	obopen(&O, outstream);
+	num = G->num;
+	obwrite(&O, BPMAGIC, 8);
+	obwrite(&O, (char *) &num, sizeof(uint64_t));
+	bpdfs(G, &O);
+	obclose(&O);
+
+	return 0;
+}
+
+
+/*
+ * Reads a tree from a .bp file. Returns NULL if infile is not in the
+ * balanced parentheses format. The roots in R are given by their (decimal)
+ * ids, the root of the graph is the first of them, or vertex 0 if R is NULL.
+ */
+struct graph *readbp(char *infile, struct roots *R) {
+	size_t size;
+	const unsigned char *map, *bits;
+	char magic[8];
+	uint64_t num, k, r;
+	struct csr C;
+	struct graph *G;
+	INT *stack, *pos, top, v;
+	char *end;
+	int b, mapped;
+
+	// check the magic bytes, also of a compressed file
+	if(inputhead(infile, magic, 8) != 8 || memcmp(magic, BPMAGIC, 8) != 0) return NULL;
+
+	map = (const unsigned char *) mapinput(infile, &size, &mapped);
+	num = 0;
+	if(size >= 8 + sizeof(uint64_t)) memcpy(&num, map + 8, sizeof(uint64_t));
+	if(num == 0 && size >= 8 + sizeof(uint64_t)) {
+		fprintf(stderr, "Error: balanced parentheses file %s is empty or corrupted.\n", infile);
+		exit(-1);
+	}
+	if(num == 0 || num > (uint64_t) size * 4
+		|| (uint64_t) size < 8 + sizeof(uint64_t) + (2 * num + 7) / 8) {
+		fprintf(stderr, "Error: balanced parentheses file %s is truncated.\n", infile);
+		exit(-1);
+	}
+	bits = map + 8 + sizeof(uint64_t);
+
+	C.num = num;
+	C.off = (INT *) calloc(num + 2, sizeof(INT));
+	C.adj = (INT *) malloc((2 * num - 1) * sizeof(INT));
+	stack = (INT *) malloc(num * sizeof(INT));
+	if(C.off == NULL || C.adj == NULL || stack == NULL) {
+		fprintf(stderr, "Memory allocation error in function readbp.\n");
+		exit(-1);
+	}
+
+	/* first pass: check the parentheses and count the degrees */
+	// the k-th "(" is vertex k, its parent is on top of the stack
+	for(k=0, v=0, top=0; k < 2*num; k++) {
+		b = (bits[k >> 3] >> (k & 7)) & 1;
+		if(b) {
+			if(v == num || (top == 0 && v > 0)) break;
+			if(top > 0) {
+				C.off[stack[top-1] + 2]++;
+				C.off[v + 2]++;
+			}
+			stack[top++] = v++;
+		} else {
+			if(top == 0) break;
+			top--;
+		}
+	}
+	if(k < 2*num || top > 0 || v < num) {
+		fprintf(stderr, "Error: balanced parentheses file %s is corrupted.\n", infile);
+		exit(-1);
+	}
+	for(v=2; v<num+2; v++)
+		C.off[v] += C.off[v-1];
+
+	/* second pass: every vertex lists its parent first and then its
+	 * children in order, just like a graph read from print_graphml() */
+	pos = C.off + 1;
+	for(k=0, v=0, top=0; k < 2*num; k++) {
+		if((bits[k >> 3] >> (k & 7)) & 1) {
+			if(top > 0) {
+				C.adj[ pos[stack[top-1]]++ ] = v;
+				C.adj[ pos[v]++ ] = stack[top-1];
+			}
+			stack[top++] = v++;
+		} else {
+			top--;
+		}
+	}
+
+	unmapinput((const char *) map, size, mapped);
+
+	G = csr2graph(&C);
+	free(C.off);
+	free(C.adj);
+	free(stack);
+
+	/* root vertices */
+	G->root = G->arr[0];
+	for(k=0; R != NULL && k<R->num; k++) {
+		r = strtoull(R->id[k], &end, 10);
+		if(*R->id[k] == '\0' || *end != '\0' || r >= num) {
+			fprintf(stderr, "Error: could not find specified root vertex id in input file.\n");
+			exit(-1);
+		}
+		R->v[k] = G->arr[r];
+	}
+	if(R != NULL) G->root = R->v[0];
+
+	return G;
+}
+
+
+// unit test for the functions of this header file, writes and reads the
+// file unit_test.bp in the working directory
+int unit_test_bp() {
+	struct graph *G, *H;
+	FILE *f;
+	INT *map, n, i;
+	int ok;
+	char name[] = "unit_test.bp";
+
+	// random trees, the vertices are read back in dfs order from the root
+	for(ok=1, n=1; n<=3000; n = 2 * n + 1) {
+		G = unit_test_tree(n);
+		G->root = G->arr[n - 1];
+		G->dfs = dfsorder(G, G->root);
+		map = (INT *) malloc(n * sizeof(INT));
+		if(map == NULL) {
+			fprintf(stderr, "Memory allocation error in function unit_test_bp.\n");
+			exit(-1);
+		}
+		for(i=0; i<n; i++)
+			map[G->dfs[i]->id] = i;
+
+		bpcheck(G);
+		f = fopen(name, "wb");
+		if(f == NULL) {
+			fprintf(stderr, "Error: could not open %s for writing.\n", name);
+			exit(-1);
+		}
+		writebp(G, f);
+		fclose(f);
+		H = readbp(name, NULL);
+		if(H == NULL || !unit_test_samegraph(G, H, map) || H->root != H->arr[0]) ok = 0;
+		if(H != NULL) free_graph(H);
+		free(map);
+		free_graph(G);
+	}
+
+	remove(name);
+	return unit_test_check(ok, "bp round trip");
+}
@@ -0,0 +1,245 @@
+/*
+ * Closeness centrality for a range of vertices with periodic checkpoints
+ *
+ * The sources start, start+1, ..., end-1 of the array src are processed in
+ * small blocks that the threads fetch on demand. Whenever a block is
+ * finished, the distance sums of its vertices are appended to a checkpoint
+ * file. A job that was killed can be restarted with the same command line;
+ * it reads the checkpoint file first and only processes the missing
+ * sources. This also allows to split a long computation into several jobs
+ * with disjoint ranges whose outputs are merged afterwards.
+ *
+ * The checkpoint file is a text file of the form
+ *
+ *		grant-checkpoint NUM START END
+ *		a b s[a] s[a+1] ... s[b-1]
+ *		...
+ *
+ * where NUM is the number of vertices of the graph and s[i] is the sum of
+ * distances from source i to all other vertices.
+ */
+
+
+// data that is shared by the threads
+struct ckptjob {
+	struct graph *G;
+	struct vertex **src;	// list of all vertices, the sources are
+							// src[start], ..., src[end-1]
+	INT start;
+	INT end;
+	INT blk;				// number of sources per block
+	char *done;				// done[i - start] != 0 if source i is finished
+	_Atomic INT next;		// first source of the next block
+	FILE *f;				// checkpoint file, may be NULL
+	pthread_mutex_t mut;	// protects the checkpoint file
+};
+
+
+/*
+ * Append the distance sums of the sources a, a+1, ..., b-1 to the
+ * checkpoint file
+ */
+void writeckpt(struct ckptjob *job, INT a, INT b) {
+	INT i;
+
+	if(job->f == NULL || b <= a) return;
+
+	pthread_mutex_lock(&job->mut);
+	fprintf(job->f, "%" STR(FINT) " %" STR(FINT), a, b);
+	for(i=a; i<b; i++)
+		fprintf(job->f, " %" STR(FINTD), job->src[i]->cent);
+	fprintf(job->f, "\n");
+	fflush(job->f);
+	pthread_mutex_unlock(&job->mut);
+}
+
+
+// worker thread: process blocks until no block is left
+void *ckptworker(void *arg) {
+	struct ckptjob *job = (struct ckptjob *) arg;
+	struct graph *G = job->G;
+	struct stat *arr;
+	struct vertex **queue;
+	INT i, a, b, run;
+
+	arr = calloc(sizeof(struct stat), G->num);
+	queue = calloc(sizeof(struct vertex *), G->num);
+	if(arr == NULL || queue == NULL) {
+		fprintf(stderr, "Memory allocation error in function ckptworker\n");
+		return (void *) -1;
+	}
+	for(i=0; i<G->num; i++)
+		arr[i].status = -1;
+
+	while(1) {
+		a = atomic_fetch_add(&job->next, job->blk);
+		if(a >= job->end) break;
+		b = (a + job->blk < job->end) ? a + job->blk : job->end;
+
+		// process the runs of unfinished sources in this block
+		for(i=a; i<b; ) {
+			if(job->done[i - job->start]) {
+				i++;
+				continue;
+			}
+			for(run=i; i<b && !job->done[i - job->start]; i++)
+				job->src[i]->cent = closenessbfs(G, job->src[i], i, arr, queue, NULL, NULL);
+			writeckpt(job, run, i);
+		}
+	}
+
+	free(arr);
+	free(queue);
+
+	return (void *) 0;
+}
+
+
+/*
+ * Reads the finished sources from an existing checkpoint file. An incomplete
+ * last record (from a job that got killed while writing) is cut off.
+ * Returns the checkpoint file opened for appending.
+ */
+FILE *readckpt(struct ckptjob *job, char *ckptfile) {
+	FILE *f;
+	char *line, *p, *q;
+	size_t cap;
+	ssize_t len;
+	long good;
+	INT num, start, end, a, b, i;
+	INTD val;
+	int ok;
+
+	f = fopen(ckptfile, "r");
+	if(f == NULL) {
+		// start a new checkpoint file
+		f = fopen(ckptfile, "w");
+		if(f == NULL) {
+			fprintf(stderr, "Error opening checkpoint file %s.\n", ckptfile);
+			exit(-1);
+		}
+		fprintf(f, "grant-checkpoint %" STR(FINT) " %" STR(FINT) " %" STR(FINT) "\n", job->G->num, job->start, job->end);
+		fflush(f);
+		return f;
+	}
+
+	// check that the checkpoint belongs to the same job
+	if(fscanf(f, "grant-checkpoint %" STR(FINT) " %" STR(FINT) " %" STR(FINT) " ", &num, &start, &end) != 3) {
+		fprintf(stderr, "Error: %s is not a checkpoint file.\n", ckptfile);
+		exit(-1);
+	}
+	if(num != job->G->num || start != job->start || end != job->end) {
+		fprintf(stderr, "Error: checkpoint file %s belongs to a different graph or vertex range.\n", ckptfile);
+		exit(-1);
+	}
+
+	// read records, remember where the last complete record ends
+	good = ftell(f);
+	line = NULL;
+	cap = 0;
+	while( (len = getline(&line, &cap, f)) > 0 ) {
+		if(line[len-1] != '\n') break;
+
+		a = strtoull(line, &p, 10);
+		b = strtoull(p, &q, 10);
+		ok = (q != p && a >= start && b <= end && a < b);
+		for(i=a; ok && i<b; i++) {
+			p = q;
+			val = strtoull(p, &q, 10);
+			if(q == p) ok = 0;
+			else job->src[i]->cent = val;
+		}
+		if(!ok) break;
+
+		for(i=a; i<b; i++)
+			job->done[i - start] = 1;
+		good = ftell(f);
+	}
+	free(line);
+	fclose(f);
+
+	// cut off the remains of an incomplete record
+	f = fopen(ckptfile, "r+");
+	if(f == NULL || ftruncate(fileno(f), good) != 0) {
+		fprintf(stderr, "Error truncating checkpoint file %s.\n", ckptfile);
+		exit(-1);
+	}
+	fclose(f);
+
+	f = fopen(ckptfile, "a");
+	if(f == NULL) {
+		fprintf(stderr, "Error opening checkpoint file %s.\n", ckptfile);
+		exit(-1);
+	}
+
+	return f;
+}
+
+
+/*
+ * Calculates the closeness centrality of the vertices src[start], ...,
+ * src[end-1] using numThreads threads. If ckptfile is not NULL, finished
+ * sources are recorded in and restored from this file.
+ */
+int rangedcentrality(struct graph *G, struct vertex **src, INT start, INT end, INT numThreads, char *ckptfile) {
+	struct ckptjob job;
+	pthread_t *th;
+	INT i;
+	void *ret;
+
+	/* sanity checks */
+	if(numThreads <= 0) return -1;
+	if(end <= start) return 0;
+	if(G->num < end) return -1;
+	if(G->num < 2) {
+		fprintf(stderr, "Closeness centrality is undefined for graphs with less than two vertices.\n");
+		return -1;
+	}
+
+	job.G = G;
+	job.src = src;
+	job.start = start;
+	job.end = end;
+	atomic_init(&job.next, start);
+	pthread_mutex_init(&job.mut, NULL);
+
+	// small blocks keep the work lost by an interruption small
+	job.blk = (end - start) / (numThreads * 100);
+	if(job.blk < 1) job.blk = 1;
+	if(job.blk > 256) job.blk = 256;
+
+	job.done = (char *) calloc(end - start, sizeof(char));
+	th = (pthread_t *) calloc(numThreads, sizeof(pthread_t));
+	if(job.done == NULL || th == NULL) {
+		fprintf(stderr, "Memory allocation error in function rangedcentrality.\n");
+		exit(-1);
+	}
+
+	job.f = NULL;
+	if(ckptfile != NULL) job.f = readckpt(&job, ckptfile);
+
+	/* launch threads */
+	for(i=0; i<numThreads; i++) {
+		if(pthread_create(&th[i], NULL, &ckptworker, &job)) {
+			fprintf(stderr, "Error launching thread number %"STR(FINT)"\n", i);
+			exit(-1);
+		}
+	}
+
+	/* wait for threads to finish */
+	for(i=0; i<numThreads; i++) {
+		pthread_join(th[i], &ret);
+		if(ret) {
+			fprintf(stderr, "Error executing thread number %"STR(FINT)"\n", i);
+			exit(-1);
+		}
+	}
+
+	/* clean up */
+	if(job.f != NULL) fclose(job.f);
+	pthread_mutex_destroy(&job.mut);
+	free(job.done);
+	free(th);
+
+	return 0;
+}
@@ -13,6 +13,10 @@ struct cmdarg
 	INT size;					// target size of random tree
 	int method;					// model of random trees
 								// 1 = GW tree conditioned on number of vertices
+								// 2 = read graph from input file
+								// 3 = merge partial centrality files
+								// 4 = extract records from containers
+								// 5 = read several graphs from files
 	const gsl_rng_type *randgen;	// type of random generator
 
 	DOUBLE beta;				// parameter for distribution
@@ -34,9 +38,29 @@ struct cmdarg
 	char *loopfile;				// file to which we write looptree
 	int Tloopfile;				// has value been set by the user?
 
+	char *loopheightfile;		// heights of the vertices in the looptree
+	int Tloopheightfile;		// has value been set by the user?
+
+	char *loopcentfile;			// closeness centrality in the looptree
+	int Tloopcentfile;			// has value been set by the user?
+
 	char *heightfile;			// file to which we write height sequence
 	int Theightfile;			// has value been set by the user?
 
+	char *widthfile;			// number of vertices at every height
+	int Twidthfile;				// has value been set by the user?
+
+	char *lukafile;				// decimated Lukasiewicz path
+	int Tlukafile;				// has value been set by the user?
+
+	char *hprocfile;			// decimated height process
+	int Thprocfile;				// has value been set by the user?
+
+	char *contourfile;			// decimated contour process
+	int Tcontourfile;			// has value been set by the user?
+
+	INT resolution;				// number of buckets of these paths
+
 	char *degfile;				// file to which we write 
 	int Tdegfile;				// has value been set by the user?
 
@@ -53,13 +77,62 @@ struct cmdarg
 								// of vertices
 	int Tcentfile;				// has value been set by the user?
 
+	char *betweenfile;			// file to which we write betweenness 
+								// centrality of vertices
+	int Tbetweenfile;			// has value been set by the user?
+
+	char *eccfile;				// file to which we write eccentricity
+								// of vertices
+	int Teccfile;				// has value been set by the user?
+
+	char *diamfile;				// file to which we write diameter, radius
+								// and center
+	int Tdiamfile;				// has value been set by the user?
+
+	char *distfile;				// file to which we write the distance
+								// distribution
+	int Tdistfile;				// has value been set by the user?
+
+	char *wienerfile;			// file to which we write the Wiener index
+								// and the average distance
+	int Twienerfile;			// has value been set by the user?
+
+	INT centstart;				// first vertex for closeness centrality
+	INT centend;				// vertex after the last one, 0 = all
+	int Tcentrange;				// has value been set by the user?
+
+	char *ckptfile;				// checkpoint file for closeness centrality
+	int Tckptfile;				// has value been set by the user?
+
+	char **mergefiles;			// partial files to merge (or containers
+								// for --extract, inputs for --batch)
+	int nummerge;				// number of these files
+	int Tmerge;					// has --merge been given?
+
 	char *infile;				// file from which we read the graph
 	int Tinfile;				// has value been set by the user?
 
-	char *vid;					// root vertex id
+	char *vid;					// root vertex id, a list of ids or @FILE
+	char **rootid;				// the ids in vid, set by rootlist()
+	INT numroots;				// number of these ids
+
+	char *batchlist;			// file with the names of more input files
+	int Tbatch;					// has --batch been given?
+
+	int reorder;				// vertex reordering before traversals
+								// 0 = none, 1 = bfs, 2 = rcm, 3 = degree
 
 	unsigned int num;			// number of samples
 	int Tnum;					// has value been set by the user?
+
+	INT queuedepth;				// number of samples that may wait for output
+	INT queuemem;				// memory limit of these samples in megabytes
+
+	int Tcontainer;				// write the samples into container files?
+
+	uint64_t extract;			// record to copy out of container files
+
+	int Tattributes;			// write vertex attributes to OUTFILE?
 };
 
 
@@ -127,6 +200,33 @@ unsigned int getnumcores(void) {
 }
 
 
+/*
+ * keys for options that only have a long name
+ */
+#define OPT_REORDER 256
+#define OPT_BETWEENFILE 257
+#define OPT_ECCFILE 258
+#define OPT_DIAMETER 259
+#define OPT_CENTRANGE 260
+#define OPT_CHECKPOINT 261
+#define OPT_MERGE 262
+#define OPT_DISTFILE 263
+#define OPT_WIENERFILE 264
+#define OPT_QUEUEDEPTH 265
+#define OPT_QUEUEMEM 266
+#define OPT_CONTAINER 267
+#define OPT_EXTRACT 268
+#define OPT_ATTRIBUTES 269
+#define OPT_BATCH 270
+#define OPT_LOOPHEIGHT 271
+#define OPT_LOOPCENT 272
+#define OPT_WIDTHFILE 273
+#define OPT_LUKAFILE 274
+#define OPT_HPROCFILE 275
+#define OPT_CONTOURFILE 276
+#define OPT_RESOLUTION 277
+
+
 /*
 	 OPTIONS.   Field 1 in ARGP.
 	 Order of fields: {NAME, KEY, ARG, FLAGS, DOC}.
@@ -136,22 +236,44 @@ static struct argp_option options[] =
 	{"tria",		'T', NULL, 0, 	"Simulate a tree with branching law P(k) = c*(k+1)*(k+2)*(1/4)**k"},
 	{"size",		's', "SIZE", 0, 	"Simulate a Galton--Watson tree conditioned on having SIZE vertices."},
 	{"poisson",		'P', NULL, 0, 	"Simulate a branching mechanism with a Poisson law."},
-	{"outfile",		'o', "OUTFILE", 0, 	"Output simulated random tree in the graphml format to OUTFILE."},
+	{"outfile",		'o', "OUTFILE", 0, 	"Output simulated random tree in the graphml format to OUTFILE. If OUTFILE ends in .gbin, a compact binary format is used instead (this also applies to LOOPFILE). If OUTFILE ends in .bp, the tree is stored as a sequence of balanced parentheses with two bits per vertex. A .gbin or .bp file holds a single graph and is overwritten, with --num use the % symbol or --container to keep every sample. Output files whose names end in .gz or .zst are compressed."},
 	{"mu", 			'm', "MU", 0, 		"Simulate with an offspring distribution that has average value MU."},
 	{"num", 		'N', "NUM", 0, 		"Simulate NUM many samples. Allows the use of the % symbol in all specified output filenames. For example, --num=100 --outfile=tree%.graphml will create the files tree001.graphml, tree002.graphml, ..., tree100.graphml."},
 	{"beta", 		'b', "BETA", 0, 	"Simulate a branching mechanism with a power law P(k) = const / k^{BETA}. Requires the -mu option."},
 	{"gamma", 		'g', "GAMMA", 0, "Simulate a branching mechanism with distribution P(k) = const / ( k^2 * ln^GAMMA(k+1) ) for k >= 1. Requires the -mu option."},
 	{"threads", 	't', "THREADS", 0,	"Distribute the workload on THREADS many threads. The default value is the number of CPU cores."}, 
 	{"loopfile",  	'l', "LOOPFILE", 0, "Output the looptree associated to the simulated random tree to LOOPFILE."},
+	{"loopheightfile", OPT_LOOPHEIGHT, "LOOPHEIGHTFILE", 0, "Output the heights of the vertices in the looptree, their distances from the root, to LOOPHEIGHTFILE. The looptree is not built."},
+	{"loopcentfile", OPT_LOOPCENT, "LOOPCENTFILE", 0, "Output a list of the vertices' closeness centrality in the looptree to LOOPCENTFILE. It is computed in linear time from the tree."},
 	{"centfile",  	'c', "CENTFILE", 0, "Output a list of the vertices' closeness centrality to CENTFILE."},
-	{"degfile",  	'd', "DEGFILE", 0, 	"Output the degrees of the depth-first-search ordered list of vertices to DEGFILE."},
+	{"attributes", 	OPT_ATTRIBUTES, NULL, 0, "Write the outdegree, the height, the parent and (together with -c) the sum of the distances to all other vertices of every vertex as attributes of the nodes in the graphml OUTFILE. These attributes are read back by --inputfile, the closeness centrality is then not computed again."},
+	{"betweenfile", OPT_BETWEENFILE, "BETWEENFILE", 0, "Output a list of the vertices' betweenness centrality to BETWEENFILE."},
+	{"eccfile",  	OPT_ECCFILE, "ECCFILE", 0, "Output a list of the vertices' eccentricity to ECCFILE."},
+	{"cent-range", 	OPT_CENTRANGE, "A:B", 0, "Calculate the closeness centrality only for the vertices A, A+1, ..., B-1 (counting from 0 in output order) and write this part of the list to CENTFILE. A missing B stands for the number of vertices. Requires --inputfile and cannot be combined with --eccfile, --distfile or --wienerfile."},
+	{"checkpoint", 	OPT_CHECKPOINT, "CKPTFILE", 0, "Record the progress of the closeness centrality computation in CKPTFILE. If the job gets restarted with the same CKPTFILE, finished vertices are not computed again. Requires --inputfile and cannot be combined with --eccfile, --distfile or --wienerfile."},
+	{"merge", 		OPT_MERGE, NULL, 0, "Merge the partial closeness centrality lists in the files given as arguments (in this order) into one list and write it to CENTFILE. Partial lists stored as NumPy arrays are merged into a CENTFILE ending in .npy."},
+	{"diameter",  	OPT_DIAMETER, "DIAMFILE", 0, "Output the diameter, the radius and the id of a center vertex as a list {diameter, radius, center} to DIAMFILE."},
+	{"distfile",  	OPT_DISTFILE, "DISTFILE", 0, "Output the distance distribution {h(1), h(2), ..., h(D)} to DISTFILE, where h(d) is the number of unordered pairs of vertices at distance d and D is the diameter."},
+	{"wienerfile", 	OPT_WIENERFILE, "WIENERFILE", 0, "Output the Wiener index (the sum of the distances of all unordered pairs of vertices) and the average distance as a list {wiener, average} to WIENERFILE."},
+	{"degfile",  	'd', "DEGFILE", 0, 	"Output the degrees of the depth-first-search ordered list of vertices to DEGFILE. If DEGFILE ends in .npy, the list is stored as a NumPy array (this applies to all lists, the degree profile, the maximal degree and the Wiener index)."},
 	{"mdegfile",  	'M', "MDEGFILE", 0, 	"Output the maximal outdegree to MDEGFILE."},
 	{"heightfile",  'h', "HEIGHTFILE", 0, "Output the height sequence to HEIGHTFILE."},
-	{"inputfile",  'i', "INPUTFILE", 0, "Read a _connected_ graph from file INFILE (graphml format) instead of generating it at random."},
+	{"widthfile", 	OPT_WIDTHFILE, "WIDTHFILE", 0, "Output the height, the width and the number of vertices at every height as a list {height, width, {W(0), W(1), ..., W(height)}} to WIDTHFILE. With --num and no % symbol in WIDTHFILE, the lists of all samples are appended to WIDTHFILE, one per line."},
+	{"lukafile", 	OPT_LUKAFILE, "LUKAFILE", 0, "Output the Lukasiewicz path of the outdegrees in breadth-first-search order to LUKAFILE, decimated to RES buckets of consecutive points as a list {{t, min, max}, ...} with the rescaled time t in [0, 1] of the first point and the smallest and largest value of every bucket. A .npy file holds an array with one row {t, min, max} per bucket. The path follows the breadth-first search, while HPROCFILE and CONTOURFILE follow the depth-first search, so the three paths of a sample do not come from the same traversal of the tree."},
+	{"hprocfile", 	OPT_HPROCFILE, "HPROCFILE", 0, "Output the height process, the heights in depth-first-search order, to HPROCFILE, decimated like LUKAFILE."},
+	{"contourfile", OPT_CONTOURFILE, "CONTOURFILE", 0, "Output the contour process to CONTOURFILE, decimated like LUKAFILE."},
+	{"resolution", 	OPT_RESOLUTION, "RES", 0, "Number of buckets of LUKAFILE, HPROCFILE and CONTOURFILE. The default is 1000."},
+	{"inputfile",  'i', "INPUTFILE", 0, "Read a graph from file INFILE (graphml, binary .gbin, balanced parentheses .bp, edge list .edges/.el/.txt/.tsv, METIS .graph/.metis or DIMACS .gr/.col/.dimacs format) instead of generating it at random. The components of a disconnected graph are analysed separately."},
+	{"batch", 		OPT_BATCH, "LIST", OPTION_ARG_OPTIONAL, "Read the graphs from all files given as arguments and, if LIST is given, from the files named in LIST (one per line, - for the standard input) as with --inputfile. The files are analysed in parallel on THREADS threads. The % symbol in output file names is replaced by the number of the input file, otherwise the outputs of all files are appended in the order of the input files."},
 	{"profile",  	'p', "PROFILE", 0, 	"Output the degree profile to the file PROFILE."},
-	{"vertex",  	'v', "VERTEX", 0, 	"Specify a root vertex. Used in conjunction with the --inputfile parameter. "},
+	{"vertex",  	'v', "VERTEX", 0, 	"Specify a root vertex. Used in conjunction with the --inputfile parameter. A comma separated list of vertices, or @FILE with one vertex per line (@- reads the standard input), analyses the graph for each of them: the heights, the width profile, the decimated paths, the looptree and its heights and closeness centrality are given for every root, all other outputs only once. The % symbol in the names of these files is replaced by the number of the root in the list."},
 	{"randgen",  	'r', "RANDGEN", 0, 	"Use the pseudo random generator RANDGEN. Available options are taus2, gfsr4, mt19937, ranlux, ranlxs0, ranlxs1, ranlxs2, ranlxd1, ranlxd2, mrg, cmrg, ranlux389. The default is taus2."},
 	{"seed", 		'S', "SEED", 0, "Specify the seed of the random generator in the first thread. Thread number k will receive SEED + k - 1 as seed. The default is to set SEED to the systems timestamp (in seconds)."},
+	{"queue-depth", OPT_QUEUEDEPTH, "DEPTH", 0, "While the outputs of a sample are written by a separate thread, the simulation of the next samples continues. At most DEPTH samples wait for their output. The default is 2, with 0 every sample is written before the next one is simulated."},
+	{"queue-mem", 	OPT_QUEUEMEM, "MB", 0, "Further samples are queued for output only while the waiting samples take less than MB megabytes of memory. The default is 1024."},
+	{"container", 	OPT_CONTAINER, NULL, 0, "Write all samples of an output into a single container file instead of one file per sample. The % symbol is dropped from the file names. Every sample is stored as a record, an index at the end of the file allows to read single records. The containers stay open for the whole run, the index is written when the run finishes. If a run is killed, the next run with the same container or --extract rebuilds the index from the complete records. Compressed containers are not supported."},
+	{"extract", 	OPT_EXTRACT, "K", 0, "Copy record number K (counting from 1) of the container files given as arguments to the standard output."},
+	{"reorder", 	OPT_REORDER, "METHOD", 0, "Renumber the vertices before calculating heights and centralities to improve cache locality on large graphs. Available methods are bfs, rcm (reverse Cuthill-McKee) and degree. Output is always given with respect to the original vertex order."},
 	{0}
 };
 
@@ -162,6 +284,7 @@ static struct argp_option options[] =
 */
 static error_t parse_opt(int key, char *arg, struct argp_state *state) {
 	struct cmdarg *arguments = state->input;
+	char *end;
 	const char *strgens[] = {"taus2", "gfsr4", "mt19937", "ranlux", "ranlxs0", "ranlxs1", "ranlxs2", "ranlxd1", "ranlxd2", "mrg", "cmrg", "ranlux389"};
 	int num;
 
@@ -286,9 +409,149 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
 			arguments->heightfile = arg;
 			arguments->Theightfile = 1;
 			break;
+		case OPT_BETWEENFILE:
+			arguments->betweenfile = arg;
+			arguments->Tbetweenfile = 1;
+			break;
+		case OPT_ECCFILE:
+			arguments->eccfile = arg;
+			arguments->Teccfile = 1;
+			break;
+		case OPT_DIAMETER:
+			arguments->diamfile = arg;
+			arguments->Tdiamfile = 1;
+			break;
+		case OPT_DISTFILE:
+			arguments->distfile = arg;
+			arguments->Tdistfile = 1;
+			break;
+		case OPT_WIENERFILE:
+			arguments->wienerfile = arg;
+			arguments->Twienerfile = 1;
+			break;
+		case OPT_CENTRANGE:
+			// range of vertices of the form A:B, A: or :B
+			arguments->centstart = (INT) strtoumax(arg, &end, 10);
+			if(*end != ':') {
+				fprintf(stderr, "Error: the --cent-range argument must have the form A:B.\n");
+				exit(-1);
+			}
+			arguments->centend = (INT) strtoumax(end + 1, &end, 10);
+			if(*end != '\0' || (arguments->centend != 0 && arguments->centend <= arguments->centstart)) {
+				fprintf(stderr, "Error: the --cent-range argument must have the form A:B with A < B.\n");
+				exit(-1);
+			}
+			arguments->Tcentrange = 1;
+			break;
+		case OPT_CHECKPOINT:
+			arguments->ckptfile = arg;
+			arguments->Tckptfile = 1;
+			break;
+		case OPT_MERGE:
+			arguments->Tmerge = 1;
+			arguments->method = 3;
+			break;
+		case ARGP_KEY_ARGS:
+			// the remaining arguments are the files for --merge or --extract
+			arguments->mergefiles = state->argv + state->next;
+			arguments->nummerge = state->argc - state->next;
+			break;
+		case ARGP_KEY_END:
+			// the modes exclude each other, whatever the order of the options
+			if((arguments->Tinfile != 0) + (arguments->Tmerge != 0) + (arguments->extract != 0) + (arguments->Tbatch != 0) > 1) {
+				argp_error(state, "only one of --inputfile, --merge, --extract and --batch can be given");
+			}
+			// the other statistics need all vertices, a partial run would
+			// mislabel them
+			if((arguments->Tcentrange || arguments->Tckptfile) && (arguments->Teccfile || arguments->Tdistfile || arguments->Twienerfile)) {
+				argp_error(state, "--cent-range and --checkpoint cannot be combined with --eccfile, --distfile or --wienerfile");
+			}
+			if(arguments->Tbatch && (arguments->Tinfile || arguments->Tcentrange || arguments->Tckptfile)) {
+				argp_error(state, "--batch cannot be combined with --inputfile, --cent-range or --checkpoint");
+			}
+			if(arguments->nummerge > 0 && arguments->method != 3 && arguments->method != 4 && arguments->method != 5) {
+				argp_error(state, "file arguments are only allowed together with --merge, --extract or --batch");
+			}
+			break;
 		case 'v':
 			arguments->vid = arg;
 			break;
+		case OPT_REORDER:
+			if( strcmp(arg, "bfs") == 0 ) {
+				arguments->reorder = REORDER_BFS;
+			} else if( strcmp(arg, "rcm") == 0 ) {
+				arguments->reorder = REORDER_RCM;
+			} else if( strcmp(arg, "degree") == 0 ) {
+				arguments->reorder = REORDER_DEG;
+			} else {
+				fprintf(stderr, "Error: Invalid value for reordering method.\n");
+				exit(-1);
+			}
+			break;
+		case OPT_QUEUEDEPTH:
+			arguments->queuedepth = (INT) strtoumax(arg, &end, 10);
+			if(*arg == '\0' || *end != '\0') {
+				fprintf(stderr, "Error: the --queue-depth parameter has to be a non-negative integer.\n");
+				exit(-1);
+			}
+			break;
+		case OPT_QUEUEMEM:
+			arguments->queuemem = (INT) strtoumax(arg, &end, 10);
+			if(*arg == '\0' || *end != '\0' || arguments->queuemem == 0) {
+				fprintf(stderr, "Error: the --queue-mem parameter has to be a positive integer.\n");
+				exit(-1);
+			}
+			break;
+		case OPT_BATCH:
+			arguments->batchlist = arg;
+			arguments->Tbatch = 1;
+			arguments->method = 5;
+			break;
+		case OPT_ATTRIBUTES:
+			arguments->Tattributes = 1;
+			break;
+		case OPT_LOOPHEIGHT:
+			arguments->loopheightfile = arg;
+			arguments->Tloopheightfile = 1;
+			break;
+		case OPT_LOOPCENT:
+			arguments->loopcentfile = arg;
+			arguments->Tloopcentfile = 1;
+			break;
+		case OPT_WIDTHFILE:
+			arguments->widthfile = arg;
+			arguments->Twidthfile = 1;
+			break;
+		case OPT_LUKAFILE:
+			arguments->lukafile = arg;
+			arguments->Tlukafile = 1;
+			break;
+		case OPT_HPROCFILE:
+			arguments->hprocfile = arg;
+			arguments->Thprocfile = 1;
+			break;
+		case OPT_CONTOURFILE:
+			arguments->contourfile = arg;
+			arguments->Tcontourfile = 1;
+			break;
+		case OPT_RESOLUTION:
+			arguments->resolution = (INT) strtoumax(arg, &end, 10);
+			if(*arg == '\0' || *end != '\0' || arguments->resolution == 0) {
+				fprintf(stderr, "Error: the --resolution parameter has to be a positive integer.\n");
+				exit(-1);
+			}
+			break;
+		case OPT_CONTAINER:
+			arguments->Tcontainer = 1;
+			break;
+		case OPT_EXTRACT:
+			arguments->extract = (uint64_t) strtoumax(arg, &end, 10);
+			if(*arg == '\0' || *end != '\0' || arguments->extract == 0) {
+				fprintf(stderr, "Error: the --extract parameter has to be a positive integer.\n");
+				exit(-1);
+			}
+			arguments->method = 4;
+			break;
 		case 'N':
 			// the number of samples
 			arguments->num = (unsigned int) strtoimax(arg, NULL, 10);
@@ -310,7 +573,7 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state) {
 	 A description of the non-option command-line arguments
 		 that we accept.
 */
-static char args_doc[] = "";
+static char args_doc[] = "[FILE...]";
 
 /*
 	DOC.	Field 4 in ARGP.
@@ -341,24 +604,84 @@ int getcmdargs(struct cmdarg *comarg, int argc, char **argv) {
 	comarg->loopfile = NULL;
 	comarg->Tloopfile = 0;
 
+	comarg->loopheightfile = NULL;
+	comarg->Tloopheightfile = 0;
+
+	comarg->loopcentfile = NULL;
+	comarg->Tloopcentfile = 0;
+
 	comarg->heightfile = NULL;
 	comarg->Theightfile = 0;
 
+	comarg->widthfile = NULL;
+	comarg->Twidthfile = 0;
+
+	comarg->lukafile = NULL;
+	comarg->Tlukafile = 0;
+
+	comarg->hprocfile = NULL;
+	comarg->Thprocfile = 0;
+
+	comarg->contourfile = NULL;
+	comarg->Tcontourfile = 0;
+
+	comarg->resolution = 1000;
+
 	comarg->profile = NULL;
 	comarg->Tprofile = 0;
 
 	comarg->centfile = NULL;
 	comarg->Tcentfile = 0;
 
+	comarg->betweenfile = NULL;
+	comarg->Tbetweenfile = 0;
+
+	comarg->eccfile = NULL;
+	comarg->Teccfile = 0;
+
+	comarg->diamfile = NULL;
+	comarg->Tdiamfile = 0;
+
+	comarg->distfile = NULL;
+	comarg->Tdistfile = 0;
+
+	comarg->wienerfile = NULL;
+	comarg->Twienerfile = 0;
+
+	comarg->centstart = 0;
+	comarg->centend = 0;
+	comarg->Tcentrange = 0;
+
+	comarg->ckptfile = NULL;
+	comarg->Tckptfile = 0;
+
+	comarg->mergefiles = NULL;
+	comarg->nummerge = 0;
+	comarg->Tmerge = 0;
+
 	comarg->infile = NULL;
 	comarg->Tinfile = 0;
 
 	comarg->vid = NULL;
+	comarg->rootid = NULL;
+	comarg->numroots = 0;
+
+	comarg->batchlist = NULL;
+	comarg->Tbatch = 0;
+
+	comarg->reorder = REORDER_NONE;
 	
 	comarg->size = 1000;
 	comarg->num = 1;
 	comarg->Tnum = 0;
 
+	comarg->queuedepth = 2;
+	comarg->queuemem = 1024;
+
+	comarg->Tcontainer = 0;
+	comarg->Tattributes = 0;
+	comarg->extract = 0;
+
 	comarg->beta = -1.0;
 	comarg->Tbeta = 0;
 	comarg->gamma = -1.0;
@@ -0,0 +1,522 @@
+/*
+ * Compressed input and output files
+ *
+ * Output files whose names end in .gz or .zst are compressed with gzip or
+ * zstd, respectively. The writers get a stream that is the write end of a
+ * pipe, a separate thread reads from the pipe, compresses the data and
+ * writes it to the file. Appending to a compressed file adds another gzip
+ * member or zstd frame, decompressors read such files as a whole.
+ *
+ * Input files are recognized by their magic bytes. Compressed files are
+ * decompressed by a separate thread that writes into a pipe, the parser
+ * reads from the other end. The format of a file is chosen by its name
+ * without the .gz or .zst suffix, or by its first bytes (see inputhead()).
+ *
+ * Usage:
+ *		f = openoutput("deg.txt.gz", "a");
+ *		fprintf(f, ...);
+ *		closestream(f);		// waits until all data is written
+ */
+
+
+#define ZBUFSIZE (1UL << 17)	// size of the buffers of the threads
+
+#define ZNONE 0
+#define ZGZIP 1
+#define ZZSTD 2
+
+#define ZSTDLEVEL 3
+
+
+// a compressed file and the pipe to the thread that handles it
+struct zstream {
+	FILE *f;			// end of the pipe used by the caller
+	FILE *file;			// the compressed file
+	int fd;				// end of the pipe used by the thread
+	int kind;			// ZGZIP or ZZSTD
+	char *name;
+	pthread_t th;
+	struct zstream *next;
+};
+
+// compressed streams that are currently open
+struct zstream *zstreams = NULL;
+pthread_mutex_t zmut = PTHREAD_MUTEX_INITIALIZER;
+
+
+// does the file name end with suffix? used to choose the output format
+int hassuffix(const char *name, const char *suffix) {
+	size_t n, s;
+
+	if(name == NULL) return 0;
+	n = strlen(name);
+	s = strlen(suffix);
+
+	return n >= s && strcmp(name + n - s, suffix) == 0;
+}
+
+
+// does the file name end with suffix, apart from the .gz or .zst suffix of a
+// compressed file? used to choose the format of a file
+int hasformat(const char *name, const char *suffix) {
+	size_t n, s;
+
+	if(name == NULL) return 0;
+	n = strlen(name);
+	s = strlen(suffix);
+	if(hassuffix(name, ".gz")) n -= 3;
+	else if(hassuffix(name, ".zst")) n -= 4;
+
+	return n >= s && strncmp(name + n - s, suffix, s) == 0;
+}
+
+
+// compression of a file, determined by the name of an output file
+int outputcompression(const char *name) {
+	if(hassuffix(name, ".gz")) return ZGZIP;
+	if(hassuffix(name, ".zst")) return ZZSTD;
+	return ZNONE;
+}
+
+
+// compression of a file, determined by its first bytes
+int inputcompression(const char *name) {
+	FILE *f;
+	unsigned char m[4];
+	size_t n;
+
+	if(name == NULL) return ZNONE;
+	f = fopen(name, "rb");
+	if(f == NULL) return ZNONE;
+	n = fread(m, 1, 4, f);
+	fclose(f);
+
+	if(n >= 2 && m[0] == 0x1f && m[1] == 0x8b) return ZGZIP;
+	if(n == 4 && m[0] == 0x28 && m[1] == 0xb5 && m[2] == 0x2f && m[3] == 0xfd) return ZZSTD;
+	return ZNONE;
+}
+
+
+// write all n bytes of buf to the file descriptor fd, returns -1 if the
+// other end of the pipe was closed
+int writeall(int fd, const unsigned char *buf, size_t n) {
+	ssize_t k;
+
+	while(n > 0) {
+		k = write(fd, buf, n);
+		if(k < 0 && errno == EINTR) continue;
+		if(k < 0 && errno == EPIPE) return -1;
+		if(k <= 0) {
+			fprintf(stderr, "Error writing to pipe.\n");
+			exit(-1);
+		}
+		buf += k;
+		n -= k;
+	}
+
+	return 0;
+}
+
+
+// read up to n bytes from the file descriptor fd, returns 0 at the end
+size_t readsome(int fd, unsigned char *buf, size_t n) {
+	ssize_t k;
+
+	do {
+		k = read(fd, buf, n);
+	} while(k < 0 && errno == EINTR);
+	if(k < 0) {
+		fprintf(stderr, "Error reading from pipe.\n");
+		exit(-1);
+	}
+
+	return (size_t) k;
+}
+
+
+void zwriteout(struct zstream *z, unsigned char *buf, size_t n) {
+	if(n > 0 && fwrite(buf, 1, n, z->file) != n) {
+		fprintf(stderr, "Error writing output file %s.\n", z->name);
+		exit(-1);
+	}
+}
+
+
+// thread: compress everything that arrives through the pipe
+void *zcompress(void *arg) {
+	struct zstream *z = (struct zstream *) arg;
+	unsigned char *in, *out;
+	size_t n;
+	z_stream s;
+	ZSTD_CCtx *c = NULL;
+	ZSTD_inBuffer zin;
+	ZSTD_outBuffer zout;
+	size_t r;
+	int ret;
+
+	in = (unsigned char *) malloc(ZBUFSIZE);
+	out = (unsigned char *) malloc(ZBUFSIZE);
+	if(in == NULL || out == NULL) {
+		fprintf(stderr, "Memory allocation error in function zcompress.\n");
+		exit(-1);
+	}
+
+	memset(&s, 0, sizeof(z_stream));
+	if(z->kind == ZGZIP) {
+		// 15 + 16: gzip header instead of zlib header
+		if(deflateInit2(&s, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+			fprintf(stderr, "Error initializing gzip compression.\n");
+			exit(-1);
+		}
+	} else {
+		c = ZSTD_createCCtx();
+		if(c == NULL || ZSTD_isError(ZSTD_CCtx_setParameter(c, ZSTD_c_compressionLevel, ZSTDLEVEL))) {
+			fprintf(stderr, "Error initializing zstd compression.\n");
+			exit(-1);
+		}
+	}
+
+	do {
+		n = readsome(z->fd, in, ZBUFSIZE);
+
+		if(z->kind == ZGZIP) {
+			s.next_in = in;
+			s.avail_in = n;
+			do {
+				s.next_out = out;
+				s.avail_out = ZBUFSIZE;
+				ret = deflate(&s, (n == 0) ? Z_FINISH : Z_NO_FLUSH);
+				if(ret == Z_STREAM_ERROR) {
+					fprintf(stderr, "Error compressing output file %s.\n", z->name);
+					exit(-1);
+				}
+				zwriteout(z, out, ZBUFSIZE - s.avail_out);
+			} while(s.avail_out == 0);
+		} else {
+			zin.src = in;
+			zin.size = n;
+			zin.pos = 0;
+			do {
+				zout.dst = out;
+				zout.size = ZBUFSIZE;
+				zout.pos = 0;
+				r = ZSTD_compressStream2(c, &zout, &zin, (n == 0) ? ZSTD_e_end : ZSTD_e_continue);
+				if(ZSTD_isError(r)) {
+					fprintf(stderr, "Error compressing output file %s: %s\n", z->name, ZSTD_getErrorName(r));
+					exit(-1);
+				}
+				zwriteout(z, out, zout.pos);
+			} while( (n == 0) ? (r != 0) : (zin.pos < zin.size) );
+		}
+	} while(n > 0);
+
+	if(z->kind == ZGZIP) deflateEnd(&s);
+	else ZSTD_freeCCtx(c);
+
+	close(z->fd);
+	if(fclose(z->file) != 0) {
+		fprintf(stderr, "Error writing output file %s.\n", z->name);
+		exit(-1);
+	}
+	free(in);
+	free(out);
+
+	return NULL;
+}
+
+
+// thread: decompress the file into the pipe
+void *zdecompress(void *arg) {
+	struct zstream *z = (struct zstream *) arg;
+	unsigned char *in, *out;
+	size_t n;
+	z_stream s;
+	ZSTD_DCtx *d = NULL;
+	ZSTD_inBuffer zin;
+	ZSTD_outBuffer zout;
+	size_t r;
+	int ret, incomplete, closed;
+#ifndef _WIN32
+	sigset_t set;
+
+	// a reader that only needs the first bytes closes the pipe early, the
+	// writes then fail with EPIPE instead of raising SIGPIPE
+	sigemptyset(&set);
+	sigaddset(&set, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+#endif
+
+	in = (unsigned char *) malloc(ZBUFSIZE);
+	out = (unsigned char *) malloc(ZBUFSIZE);
+	if(in == NULL || out == NULL) {
+		fprintf(stderr, "Memory allocation error in function zdecompress.\n");
+		exit(-1);
+	}
+
+	memset(&s, 0, sizeof(z_stream));
+	if(z->kind == ZGZIP) {
+		// 15 + 32: detect the gzip header
+		if(inflateInit2(&s, 15 + 32) != Z_OK) {
+			fprintf(stderr, "Error initializing gzip decompression.\n");
+			exit(-1);
+		}
+	} else {
+		d = ZSTD_createDCtx();
+		if(d == NULL) {
+			fprintf(stderr, "Error initializing zstd decompression.\n");
+			exit(-1);
+		}
+	}
+
+	// incomplete != 0 while a gzip member or zstd frame is unfinished
+	incomplete = 0;
+	closed = 0;
+	while( !closed && (n = fread(in, 1, ZBUFSIZE, z->file)) > 0 ) {
+		if(z->kind == ZGZIP) {
+			s.next_in = in;
+			s.avail_in = n;
+			do {
+				s.next_out = out;
+				s.avail_out = ZBUFSIZE;
+				ret = inflate(&s, Z_NO_FLUSH);
+				if(ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+					fprintf(stderr, "Error: input file %s is corrupted.\n", z->name);
+					exit(-1);
+				}
+				if(writeall(z->fd, out, ZBUFSIZE - s.avail_out) != 0) {
+					closed = 1;
+					break;
+				}
+				incomplete = (ret != Z_STREAM_END);
+				// the next member of a concatenated file
+				if(ret == Z_STREAM_END) inflateReset(&s);
+			} while(s.avail_in > 0 || s.avail_out == 0);
+		} else {
+			zin.src = in;
+			zin.size = n;
+			zin.pos = 0;
+			do {
+				zout.dst = out;
+				zout.size = ZBUFSIZE;
+				zout.pos = 0;
+				r = ZSTD_decompressStream(d, &zout, &zin);
+				if(ZSTD_isError(r)) {
+					fprintf(stderr, "Error: input file %s is corrupted (%s).\n", z->name, ZSTD_getErrorName(r));
+					exit(-1);
+				}
+				if(writeall(z->fd, out, zout.pos) != 0) {
+					closed = 1;
+					break;
+				}
+				incomplete = (r != 0);
+			} while(zin.pos < zin.size || zout.pos == zout.size);
+		}
+	}
+	if(ferror(z->file) || (incomplete && !closed)) {
+		fprintf(stderr, "Error: input file %s is truncated.\n", z->name);
+		exit(-1);
+	}
+
+	if(z->kind == ZGZIP) inflateEnd(&s);
+	else ZSTD_freeDCtx(d);
+
+	close(z->fd);
+	fclose(z->file);
+	free(in);
+	free(out);
+
+	return NULL;
+}
+
+
+/*
+ * Opens a pipe to a new thread that compresses (output != 0) into or
+ * decompresses from the file, returns the caller's end of the pipe
+ */
+FILE *zopen(FILE *file, char *name, int kind, int output) {
+	struct zstream *z;
+	int fds[2];
+
+#ifdef _WIN32
+	fprintf(stderr, "Error: compressed files are not supported on this platform.\n");
+	exit(-1);
+#endif
+
+	z = (struct zstream *) malloc(sizeof(struct zstream));
+	if(z == NULL || pipe(fds) != 0) {
+		fprintf(stderr, "Error creating pipe for file %s.\n", name);
+		exit(-1);
+	}
+	z->file = file;
+	z->kind = kind;
+	z->name = name;
+	z->f = fdopen(output ? fds[1] : fds[0], output ? "w" : "r");
+	z->fd = output ? fds[0] : fds[1];
+	if(z->f == NULL) {
+		fprintf(stderr, "Error creating pipe for file %s.\n", name);
+		exit(-1);
+	}
+
+	if(pthread_create(&z->th, NULL, output ? &zcompress : &zdecompress, z)) {
+		fprintf(stderr, "Error launching thread for file %s.\n", name);
+		exit(-1);
+	}
+
+	pthread_mutex_lock(&zmut);
+	z->next = zstreams;
+	zstreams = z;
+	pthread_mutex_unlock(&zmut);
+
+	return z->f;
+}
+
+
+/*
+ * Opens an output file like fopen(outfile, mode), the data is compressed
+ * if the name ends in .gz or .zst. If outfile is a container, the data goes
+ * to a new record of it. Returns NULL on failure.
+ */
+FILE *openoutput(char *outfile, const char *mode) {
+	FILE *file;
+	int kind;
+
+	// a new record of a container file
+	file = containeropen(outfile);
+	if(file != NULL) return file;
+
+	file = fopen(outfile, mode);
+	kind = outputcompression(outfile);
+	if(file == NULL || kind == ZNONE) return file;
+
+	return zopen(file, outfile, kind, 1);
+}
+
+
+/*
+ * Opens an input file for reading, compressed files are decompressed.
+ * Returns NULL on failure.
+ */
+FILE *openinput(char *infile) {
+	FILE *file;
+	int kind;
+
+	kind = inputcompression(infile);
+	file = fopen(infile, "r");
+	if(file == NULL || kind == ZNONE) return file;
+
+	return zopen(file, infile, kind, 0);
+}
+
+
+// closes a stream from openoutput() or openinput()
+int closestream(FILE *f) {
+	struct zstream *z, **p;
+	int ret;
+
+	// containers stay open until the end of the run
+	if(containerclose(f)) return 0;
+
+	pthread_mutex_lock(&zmut);
+	for(p = &zstreams; *p != NULL && (*p)->f != f; p = &(*p)->next);
+	z = *p;
+	if(z != NULL) *p = z->next;
+	pthread_mutex_unlock(&zmut);
+
+	ret = fclose(f);
+	if(z != NULL) {
+		pthread_join(z->th, NULL);
+		free(z);
+	}
+
+	return ret;
+}
+
+
+/*
+ * Reads up to n bytes from the beginning of the input file into buf, after
+ * decompressing it, returns the number of bytes read. The binary formats are
+ * recognized by these bytes.
+ */
+size_t inputhead(char *infile, void *buf, size_t n) {
+	FILE *f;
+	size_t k;
+
+	if(infile == NULL) return 0;
+	f = openinput(infile);
+	if(f == NULL) return 0;
+	k = fread(buf, 1, n, f);
+	closestream(f);
+
+	return k;
+}
+
+
+/*
+ * Maps the input file into memory, or decompresses it into a buffer. Sets
+ * *len to the number of bytes and mapped to 1 if the file was mapped,
+ * unmapinput() releases the memory.
+ */
+const char *mapinput(char *infile, size_t *len, int *mapped) {
+	FILE *f;
+	off_t size;
+	size_t cap, r;
+	char *buf;
+	const char *map;
+
+	*mapped = 0;
+	if(inputcompression(infile) == ZNONE) {
+		f = fopen(infile, "r");
+		if(f == NULL) {
+			fprintf(stderr, "Error opening input file %s.\n", infile);
+			exit(-1);
+		}
+		size = lseek(fileno(f), 0, SEEK_END);
+#ifndef _WIN32
+		map = (size > 0) ? (const char *) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(f), 0) : MAP_FAILED;
+		if(map != MAP_FAILED) {
+			*mapped = 1;
+			*len = size;
+		}
+#endif
+		fclose(f);
+		if(*mapped) return map;
+	}
+
+	f = openinput(infile);
+	if(f == NULL) {
+		fprintf(stderr, "Error opening input file %s.\n", infile);
+		exit(-1);
+	}
+	*len = 0;
+	cap = 1UL << 20;
+	buf = (char *) malloc(cap);
+	while(buf != NULL && (r = fread(buf + *len, 1, cap - *len, f)) > 0) {
+		*len += r;
+		if(*len == cap) {
+			cap *= 2;
+			buf = (char *) realloc(buf, cap);
+		}
+	}
+	if(buf == NULL) {
+		fprintf(stderr, "Memory allocation error in function mapinput.\n");
+		exit(-1);
+	}
+	if(ferror(f)) {
+		fprintf(stderr, "Error reading input file %s.\n", infile);
+		exit(-1);
+	}
+	closestream(f);
+
+	return buf;
+}
+
+
+void unmapinput(const char *map, size_t len, int mapped) {
+#ifndef _WIN32
+	if(mapped) {
+		munmap((void *) map, len);
+		return;
+	}
+#endif
+	free((char *) map);
+}
@@ -0,0 +1,368 @@
+/*
+ * Indexed container files
+ *
+ * With --container, all samples of an output go into a single file instead
+ * of one file per sample. Every time an output file would have been opened,
+ * written and closed, the data is appended to the container as a new record.
+ * The containers stay open for the whole run, an index of the records is
+ * written to the end of the file when the run finishes:
+ *
+ *		char magic[8]			"GRANTPAK"
+ *		count times:
+ *			char tag[8]			"GRANTREC"
+ *			uint64 length		length of the record in bytes, PAKOPEN while
+ *								it is written
+ *			data[length]		the record
+ *		count times:
+ *			uint64 offset		position of the data of the record in the file
+ *			uint64 length		length of the record in bytes
+ *		uint64 count			number of records
+ *		uint64 index			position of the first index entry
+ *		char magic[8]			"GRANTIDX"
+ *
+ * The data of a record is exactly what would have been written to the file
+ * of the sample (graphml, .gbin or .bp graphs, lists), so --extract can copy
+ * it out after seeking to it. Running again with the same container appends
+ * records and rewrites the index.
+ *
+ * A run that is killed does not write the index. The headers of the records
+ * allow to rebuild it: a container without index is scanned record by
+ * record when it is opened again or read by --extract, a record that was
+ * still being written is dropped.
+ */
+
+
+#define PAKMAGIC "GRANTPAK"
+#define IDXMAGIC "GRANTIDX"
+#define RECMAGIC "GRANTREC"
+
+#define PAKOPEN UINT64_MAX		// length of a record that is being written
+#define PAKRECHEAD 16			// size of the header of a record
+
+#define PAKBUFSIZE (1UL << 17)	// buffer for copying records
+
+
+struct container {
+	char *name;
+	FILE *f;
+	off_t pos;				// end of the last record
+	off_t start;			// start of the data of the record being written
+	int busy;				// is a record being written?
+	uint64_t *idx;			// offset and length of every record
+	uint64_t count;
+	uint64_t cap;
+	struct container *next;
+};
+
+// containers of this run
+struct container *containers = NULL;
+pthread_mutex_t cmut = PTHREAD_MUTEX_INITIALIZER;
+
+
+/*
+ * Reads the trailer of a container. Returns 0 if f is not a container and -1
+ * if it is a container without a complete index.
+ */
+int readtrailer(FILE *f, uint64_t *count, uint64_t *index) {
+	char magic[8];
+	off_t size;
+
+	if(fseeko(f, 0, SEEK_END) != 0) return 0;
+	size = ftello(f);
+	if(size < 8) return 0;
+
+	if(fseeko(f, 0, SEEK_SET) != 0 || fread(magic, 1, 8, f) != 8 || memcmp(magic, PAKMAGIC, 8) != 0)
+		return 0;
+	if(size < 8 + 2 * (off_t) sizeof(uint64_t) + 8
+		|| fseeko(f, size - 8 - 2 * sizeof(uint64_t), SEEK_SET) != 0
+		|| fread(count, sizeof(uint64_t), 1, f) != 1
+		|| fread(index, sizeof(uint64_t), 1, f) != 1
+		|| fread(magic, 1, 8, f) != 8 || memcmp(magic, IDXMAGIC, 8) != 0)
+		return -1;
+
+	// the index has to fit between the header and the trailer
+	if(*index < 8 || *index > (uint64_t) size || *count > ((uint64_t) size - *index) / (2 * sizeof(uint64_t))
+		|| *index + *count * 2 * sizeof(uint64_t) + 2 * sizeof(uint64_t) + 8 != (uint64_t) size)
+		return -1;
+
+	return 1;
+}
+
+
+// adds a record to the index of the container c
+void addrecord(struct container *c, uint64_t offset, uint64_t length) {
+	if(c->count == c->cap) {
+		c->cap = 2 * c->cap + 64;
+		c->idx = (uint64_t *) realloc(c->idx, 2 * c->cap * sizeof(uint64_t));
+		if(c->idx == NULL) {
+			fprintf(stderr, "Memory allocation error in function addrecord.\n");
+			exit(-1);
+		}
+	}
+	c->idx[2 * c->count] = offset;
+	c->idx[2 * c->count + 1] = length;
+	c->count++;
+}
+
+
+/*
+ * Rebuilds the index of a container without index from the headers of its
+ * records. The scan stops at the first record that is incomplete, c->pos is
+ * set to its start.
+ */
+void scanrecords(struct container *c) {
+	char tag[8];
+	uint64_t length;
+	off_t size;
+
+	if(fseeko(c->f, 0, SEEK_END) != 0) {
+		fprintf(stderr, "Error reading container file %s.\n", c->name);
+		exit(-1);
+	}
+	size = ftello(c->f);
+
+	c->pos = 8;
+	while(size - c->pos >= PAKRECHEAD) {
+		if(fseeko(c->f, c->pos, SEEK_SET) != 0
+			|| fread(tag, 1, 8, c->f) != 8 || memcmp(tag, RECMAGIC, 8) != 0
+			|| fread(&length, sizeof(uint64_t), 1, c->f) != 1
+			|| length == PAKOPEN || length > (uint64_t) (size - c->pos - PAKRECHEAD))
+			break;
+		addrecord(c, (uint64_t) c->pos + PAKRECHEAD, length);
+		c->pos += PAKRECHEAD + (off_t) length;
+	}
+}
+
+
+/*
+ * Opens the container name for the rest of the run, the container frees name
+ * in the end. An existing container keeps its records, its index is removed
+ * and new records are appended. The index of a container that was not closed
+ * is rebuilt from the headers of the records.
+ */
+void newcontainer(char *name) {
+	struct container *c;
+	uint64_t index;
+	off_t size;
+	int ret;
+
+	c = (struct container *) calloc(1, sizeof(struct container));
+	if(c == NULL) {
+		fprintf(stderr, "Memory allocation error in function newcontainer.\n");
+		exit(-1);
+	}
+	c->name = name;
+
+	c->f = fopen(name, "r+b");
+	if(c->f == NULL) c->f = fopen(name, "w+b");
+	if(c->f == NULL || fseeko(c->f, 0, SEEK_END) != 0) {
+		fprintf(stderr, "Error opening output file %s.\n", name);
+		exit(-1);
+	}
+	size = ftello(c->f);
+
+	if(size == 0) {
+		if(fwrite(PAKMAGIC, 1, 8, c->f) != 8) {
+			fprintf(stderr, "Error writing output file %s.\n", name);
+			exit(-1);
+		}
+		c->pos = 8;
+	} else if((ret = readtrailer(c->f, &c->count, &index)) == 0) {
+		fprintf(stderr, "Error: %s exists and is not a container file.\n", name);
+		exit(-1);
+	} else if(ret < 0) {
+		c->count = 0;
+		scanrecords(c);
+		fprintf(stderr, "Container file %s was not closed, its index was rebuilt from %llu complete records.\n", name, (unsigned long long) c->count);
+	} else {
+		c->cap = c->count;
+		c->idx = (uint64_t *) malloc((2 * c->cap + 2) * sizeof(uint64_t));
+		if(c->idx == NULL) {
+			fprintf(stderr, "Memory allocation error in function newcontainer.\n");
+			exit(-1);
+		}
+		if(fseeko(c->f, index, SEEK_SET) != 0 || fread(c->idx, sizeof(uint64_t), 2 * c->count, c->f) != 2 * c->count) {
+			fprintf(stderr, "Error reading container file %s.\n", name);
+			exit(-1);
+		}
+		c->pos = index;
+	}
+
+	// cut off the old index and the remains of an incomplete record, so that
+	// a stale trailer cannot be mistaken for the index of the new records
+	if(size > 0 && (fflush(c->f) != 0 || ftruncate(fileno(c->f), c->pos) != 0)) {
+		fprintf(stderr, "Error truncating container file %s.\n", name);
+		exit(-1);
+	}
+
+	pthread_mutex_lock(&cmut);
+	c->next = containers;
+	containers = c;
+	pthread_mutex_unlock(&cmut);
+}
+
+
+/*
+ * Starts a new record if name is a container and returns the stream to write
+ * it to, returns NULL otherwise
+ */
+FILE *containeropen(char *name) {
+	struct container *c;
+	uint64_t length;
+
+	if(name == NULL) return NULL;
+	length = PAKOPEN;
+
+	pthread_mutex_lock(&cmut);
+	for(c = containers; c != NULL && strcmp(c->name, name) != 0; c = c->next);
+	pthread_mutex_unlock(&cmut);
+	if(c == NULL) return NULL;
+
+	if(c->busy) {
+		fprintf(stderr, "Error: container file %s is written twice at the same time.\n", name);
+		exit(-1);
+	}
+	// the length of the record is filled in by containerclose()
+	if(fseeko(c->f, c->pos, SEEK_SET) != 0 || fwrite(RECMAGIC, 1, 8, c->f) != 8
+		|| fwrite(&length, sizeof(uint64_t), 1, c->f) != 1) {
+		fprintf(stderr, "Error writing output file %s.\n", name);
+		exit(-1);
+	}
+	c->start = c->pos + PAKRECHEAD;
+	c->busy = 1;
+
+	return c->f;
+}
+
+
+/*
+ * Finishes the record that is written to f, returns 0 if f does not belong
+ * to a container
+ */
+int containerclose(FILE *f) {
+	struct container *c;
+	uint64_t length;
+
+	pthread_mutex_lock(&cmut);
+	for(c = containers; c != NULL && !(c->f == f && c->busy); c = c->next);
+	pthread_mutex_unlock(&cmut);
+	if(c == NULL) return 0;
+
+	if(fflush(f) != 0 || (c->pos = ftello(f)) < c->start) {
+		fprintf(stderr, "Error writing output file %s.\n", c->name);
+		exit(-1);
+	}
+
+	// the record is complete once its length is written
+	length = (uint64_t) (c->pos - c->start);
+	if(fseeko(f, c->start - sizeof(uint64_t), SEEK_SET) != 0
+		|| fwrite(&length, sizeof(uint64_t), 1, f) != 1 || fflush(f) != 0) {
+		fprintf(stderr, "Error writing output file %s.\n", c->name);
+		exit(-1);
+	}
+	addrecord(c, (uint64_t) c->start, length);
+	c->busy = 0;
+
+	return 1;
+}
+
+
+// writes the indices and closes all containers
+void closecontainers(void) {
+	struct container *c;
+	uint64_t index;
+
+	while(containers != NULL) {
+		c = containers;
+		containers = c->next;
+
+		index = (uint64_t) c->pos;
+		if(fseeko(c->f, c->pos, SEEK_SET) != 0
+			|| fwrite(c->idx, sizeof(uint64_t), 2 * c->count, c->f) != 2 * c->count
+			|| fwrite(&c->count, sizeof(uint64_t), 1, c->f) != 1
+			|| fwrite(&index, sizeof(uint64_t), 1, c->f) != 1
+			|| fwrite(IDXMAGIC, 1, 8, c->f) != 8
+			|| fclose(c->f) != 0) {
+			fprintf(stderr, "Error writing output file %s.\n", c->name);
+			exit(-1);
+		}
+
+		free(c->idx);
+		free(c->name);
+		free(c);
+	}
+}
+
+
+/*
+ * Copies record number k (counting from 1) of the container name to
+ * outstream, also if the index of the container was not written
+ */
+int extractrecord(char *name, uint64_t k, FILE *outstream) {
+	FILE *f;
+	struct container c;
+	uint64_t count, index, entry[2];
+	char *buf;
+	size_t n;
+	int ret;
+
+	f = fopen(name, "rb");
+	if(f == NULL) {
+		fprintf(stderr, "Error opening container file %s.\n", name);
+		exit(-1);
+	}
+	ret = readtrailer(f, &count, &index);
+	if(ret == 0) {
+		fprintf(stderr, "Error: %s is not a container file.\n", name);
+		exit(-1);
+	}
+
+	// without index the records are found by their headers
+	memset(&c, 0, sizeof(struct container));
+	if(ret < 0) {
+		c.name = name;
+		c.f = f;
+		scanrecords(&c);
+		count = c.count;
+		index = (uint64_t) c.pos;
+	}
+	if(k == 0 || k > count) {
+		fprintf(stderr, "Error: container file %s has only %llu records.\n", name, (unsigned long long) count);
+		exit(-1);
+	}
+
+	// the entry of the record and then the record itself
+	if(ret < 0) {
+		entry[0] = c.idx[2 * (k-1)];
+		entry[1] = c.idx[2 * (k-1) + 1];
+		free(c.idx);
+	} else if(fseeko(f, index + 2 * (k-1) * sizeof(uint64_t), SEEK_SET) != 0
+		|| fread(entry, sizeof(uint64_t), 2, f) != 2) {
+		fprintf(stderr, "Error: container file %s is corrupted.\n", name);
+		exit(-1);
+	}
+	if(entry[0] < 8 || entry[0] > index || entry[1] > index - entry[0]
+		|| fseeko(f, entry[0], SEEK_SET) != 0) {
+		fprintf(stderr, "Error: container file %s is corrupted.\n", name);
+		exit(-1);
+	}
+
+	buf = (char *) malloc(PAKBUFSIZE);
+	if(buf == NULL) {
+		fprintf(stderr, "Memory allocation error in function extractrecord.\n");
+		exit(-1);
+	}
+	while(entry[1] > 0) {
+		n = (entry[1] < PAKBUFSIZE) ? entry[1] : PAKBUFSIZE;
+		if(fread(buf, 1, n, f) != n || fwrite(buf, 1, n, outstream) != n) {
+			fprintf(stderr, "Error copying a record of container file %s.\n", name);
+			exit(-1);
+		}
+		entry[1] -= n;
+	}
+
+	free(buf);
+	fclose(f);
+
+	return 0;
+}
@@ -0,0 +1,363 @@
+/*
+ * Binary graph format (.gbin)
+ *
+ * Graphs written to a file whose name ends in .gbin are stored in a compact
+ * binary format instead of graphml. Such files are recognized by --inputfile
+ * and mapped into memory, the graph is built directly from the mapped
+ * arrays without any parsing.
+ *
+ * All fields are unsigned 64 bit integers in the byte order of the machine
+ * that wrote the file (readers check the byte order mark):
+ *
+ *		header:
+ *			char magic[8]			"GRANTBIN"
+ *			uint32 version			GBINVERSION
+ *			uint32 byte order mark	0x01020304
+ *			num						number of vertices
+ *			nadj					number of entries of the neighbourhood lists
+ *			root					id of the root vertex, num if there is none
+ *			ncols					number of attribute columns
+ *			flags					bit 0: every edge is stored in both directions
+ *			reserved
+ *		off[num+1]				the neighbours of vertex v are
+ *		adj[nadj]				adj[off[v]], ..., adj[off[v+1]-1]
+ *		ncols times:
+ *			char name[24]			name of the attribute (NUL-terminated)
+ *			type					GBINCOL_UINT or GBINCOL_DOUBLE
+ *			count					number of values
+ *			values[count]			64 bit values
+ *
+ * The neighbourhood lists are stored in the order in which the graphml reader
+ * rebuilds them from the output of print_graphml(). Reading a .gbin file
+ * hence yields the same graph as reading the graphml file of the same graph.
+ * Readers skip attribute columns they do not know.
+ */
+
+
+#define GBINMAGIC "GRANTBIN"
+#define GBINVERSION 1
+#define GBINBOM 0x01020304U
+
+#define GBINCOL_UINT 1
+#define GBINCOL_DOUBLE 2
+
+#define GBIN_UNDIRECTED 1
+
+
+struct gbinheader {
+	char magic[8];
+	uint32_t version;
+	uint32_t bom;
+	uint64_t num;
+	uint64_t nadj;
+	uint64_t root;
+	uint64_t ncols;
+	uint64_t flags;
+	uint64_t reserved;
+};
+
+struct gbincolumn {
+	char name[24];
+	uint64_t type;
+	uint64_t count;
+};
+
+
+/*
+ * Writes the undirected graph G in the binary format. The graph is assumed
+ * to consist of pairs of di-edges, as for print_graphml().
+ */
+int writegbin(struct graph *G, FILE *outstream) {
+	struct gbinheader h;
+	uint64_t *off, *adj, *pos;
+	INT i;
+	struct list *li;
+
+	memset(&h, 0, sizeof(struct gbinheader));
+	memcpy(h.magic, GBINMAGIC, 8);
+	h.version = GBINVERSION;
+	h.bom = GBINBOM;
+	h.num = G->num;
+	h.root = (G->root != NULL) ? G->root->id : G->num;
+	h.ncols = 0;
+	h.flags = GBIN_UNDIRECTED;
+
+	off = (uint64_t *) calloc(G->num + 1, sizeof(uint64_t));
+	pos = (uint64_t *) calloc(G->num + 1, sizeof(uint64_t));
+	if(off == NULL || pos == NULL) {
+		fprintf(stderr, "Memory allocation error in function writegbin.\n");
+		exit(-1);
+	}
+
+	// print_graphml() writes the edge {i, j} with i < j while going through
+	// the neighbours of i, the reader appends j to the list of i and i to
+	// the list of j
+	for(i=0; i<G->num; i++) {
+		for(li = G->arr[i]->qu->li; li != NULL; li = li->ne) {
+			if(li->ve->id > i) {
+				off[i+1]++;
+				off[li->ve->id + 1]++;
+			}
+		}
+	}
+	for(i=0; i<G->num; i++) {
+		off[i+1] += off[i];
+		pos[i] = off[i];
+	}
+	h.nadj = off[G->num];
+
+	adj = (uint64_t *) calloc(h.nadj + 1, sizeof(uint64_t));
+	if(adj == NULL) {
+		fprintf(stderr, "Memory allocation error in function writegbin.\n");
+		exit(-1);
+	}
+	for(i=0; i<G->num; i++) {
+		for(li = G->arr[i]->qu->li; li != NULL; li = li->ne) {
+			if(li->ve->id > i) {
+				adj[ pos[i]++ ] = li->ve->id;
+				adj[ pos[li->ve->id]++ ] = i;
+			}
+		}
+	}
+
+	if(fwrite(&h, sizeof(struct gbinheader), 1, outstream) != 1
+		|| fwrite(off, sizeof(uint64_t), G->num + 1, outstream) != G->num + 1
+		|| fwrite(adj, sizeof(uint64_t), h.nadj, outstream) != h.nadj) {
+		fprintf(stderr, "Error writing binary graph.\n");
+		exit(-1);
+	}
+
+	free(off);
+	free(pos);
+	free(adj);
+
+	return 0;
+}
+
+
+struct gbinloop {
+	uint64_t *off;
+	uint64_t *pos;
+	uint64_t *adj;
+};
+
+void gbinloopcount(INT s, INT t, void *arg) {
+	struct gbinloop *L = (struct gbinloop *) arg;
+
+	L->off[s+1]++;
+	L->off[t+1]++;
+}
+
+void gbinloopfill(INT s, INT t, void *arg) {
+	struct gbinloop *L = (struct gbinloop *) arg;
+
+	L->adj[ L->pos[s]++ ] = t;
+	L->adj[ L->pos[t]++ ] = s;
+}
+
+
+/*
+ * Writes the looptree of the tree G in the binary format, the lists are
+ * filled directly from the edges given by loopedges() with the heights
+ * height. The file holds the same graph as writegbin() of looptree().
+ */
+int writeloopgbin(struct graph *G, INT *height, FILE *outstream) {
+	struct gbinheader h;
+	struct gbinloop L;
+	INT i;
+
+	memset(&h, 0, sizeof(struct gbinheader));
+	memcpy(h.magic, GBINMAGIC, 8);
+	h.version = GBINVERSION;
+	h.bom = GBINBOM;
+	h.num = G->num;
+	h.root = G->num;
+	h.ncols = 0;
+	h.flags = GBIN_UNDIRECTED;
+
+	L.off = (uint64_t *) calloc(G->num + 1, sizeof(uint64_t));
+	L.pos = (uint64_t *) calloc(G->num + 1, sizeof(uint64_t));
+	if(L.off == NULL || L.pos == NULL) {
+		fprintf(stderr, "Memory allocation error in function writeloopgbin.\n");
+		exit(-1);
+	}
+
+	for(i=0; i<G->num; i++)
+		loopedges(G, height, i, &gbinloopcount, &L);
+	for(i=0; i<G->num; i++) {
+		L.off[i+1] += L.off[i];
+		L.pos[i] = L.off[i];
+	}
+	h.nadj = L.off[G->num];
+
+	L.adj = (uint64_t *) calloc(h.nadj + 1, sizeof(uint64_t));
+	if(L.adj == NULL) {
+		fprintf(stderr, "Memory allocation error in function writeloopgbin.\n");
+		exit(-1);
+	}
+	for(i=0; i<G->num; i++)
+		loopedges(G, height, i, &gbinloopfill, &L);
+
+	if(fwrite(&h, sizeof(struct gbinheader), 1, outstream) != 1
+		|| fwrite(L.off, sizeof(uint64_t), G->num + 1, outstream) != G->num + 1
+		|| fwrite(L.adj, sizeof(uint64_t), h.nadj, outstream) != h.nadj) {
+		fprintf(stderr, "Error writing binary graph.\n");
+		exit(-1);
+	}
+
+	free(L.off);
+	free(L.pos);
+	free(L.adj);
+
+	return 0;
+}
+
+
+/*
+ * Reads a graph from a .gbin file. Returns NULL if infile is not a binary
+ * graph file. The roots in R are given by their (decimal) ids, the root of
+ * the graph is the first of them, or the root stored in the file if R is
+ * NULL.
+ */
+struct graph *readgbin(char *infile, struct roots *R) {
+	size_t size;
+	const char *map;
+	struct gbinheader h;
+	struct csr C;
+	struct graph *G;
+	INT i, k, *tmp;
+	uint64_t *off, *adj, r;
+	char *end;
+	int mapped;
+
+	// check the magic bytes, also of a compressed file
+	if(inputhead(infile, &h, sizeof(struct gbinheader)) != sizeof(struct gbinheader)
+		|| memcmp(h.magic, GBINMAGIC, 8) != 0) return NULL;
+
+	if(h.version != GBINVERSION || h.bom != GBINBOM) {
+		fprintf(stderr, "Error: %s was written by an incompatible version or machine.\n", infile);
+		exit(-1);
+	}
+	map = mapinput(infile, &size, &mapped);
+	if(h.num == 0) {
+		fprintf(stderr, "Error: binary graph file %s is empty or corrupted.\n", infile);
+		exit(-1);
+	}
+	if(h.num >= (uint64_t) size || h.nadj >= (uint64_t) size
+		|| (uint64_t) size < sizeof(struct gbinheader) + (h.num + 1 + h.nadj) * sizeof(uint64_t)) {
+		fprintf(stderr, "Error: binary graph file %s is truncated.\n", infile);
+		exit(-1);
+	}
+	off = (uint64_t *) (map + sizeof(struct gbinheader));
+	adj = off + h.num + 1;
+
+	// a corrupted file must not lead to invalid memory accesses
+	for(i=0; i<h.num; i++) {
+		if(off[i] > off[i+1]) break;
+	}
+	if(off[0] != 0 || i < h.num || off[h.num] != h.nadj) {
+		fprintf(stderr, "Error: binary graph file %s is corrupted.\n", infile);
+		exit(-1);
+	}
+	for(i=0; i<h.nadj; i++) {
+		if(adj[i] >= h.num) {
+			fprintf(stderr, "Error: binary graph file %s is corrupted.\n", infile);
+			exit(-1);
+		}
+	}
+
+	/* build the graph straight from the mapped arrays */
+	C.num = h.num;
+	if(sizeof(INT) == sizeof(uint64_t)) {
+		C.off = (INT *) off;
+		C.adj = (INT *) adj;
+		G = csr2graph(&C);
+	} else {
+		tmp = (INT *) calloc(h.num + 1 + h.nadj, sizeof(INT));
+		if(tmp == NULL) {
+			fprintf(stderr, "Memory allocation error in function readgbin.\n");
+			exit(-1);
+		}
+		for(i=0; i < h.num + 1 + h.nadj; i++)
+			tmp[i] = (INT) off[i];
+		C.off = tmp;
+		C.adj = tmp + h.num + 1;
+		G = csr2graph(&C);
+		free(tmp);
+	}
+
+	unmapinput(map, size, mapped);
+
+	/* specify root vertex */
+	if(h.root < h.num) G->root = G->arr[h.root];
+	for(k=0; R != NULL && k<R->num; k++) {
+		r = strtoull(R->id[k], &end, 10);
+		if(*R->id[k] == '\0' || *end != '\0' || r >= h.num) {
+			fprintf(stderr, "Error: could not find specified root vertex id in input file.\n");
+			exit(-1);
+		}
+		R->v[k] = G->arr[r];
+	}
+	if(R != NULL) G->root = R->v[0];
+
+	return G;
+}
+
+
+// unit test for the functions of this header file, writes and reads the
+// file unit_test.gbin in the working directory
+int unit_test_gbin() {
+	struct graph *G, *H, *L;
+	FILE *f;
+	INT n, i, k, r;
+	int ok, fail;
+	char name[] = "unit_test.gbin";
+
+	fail = 0;
+
+	// random graphs with cycles, the root is kept
+	for(ok=1, n=1; n<=500; n = 3 * n + 1) {
+		G = unit_test_tree(n);
+		for(k=0; k<n; k++) {
+			i = (INT) rand() % n;
+			r = (INT) rand() % n;
+			if(i < r) addEdge(G->arr[i], G->arr[r]);
+		}
+		G->root = G->arr[n / 2];
+		f = fopen(name, "wb");
+		if(f == NULL) {
+			fprintf(stderr, "Error: could not open %s for writing.\n", name);
+			exit(-1);
+		}
+		writegbin(G, f);
+		fclose(f);
+		H = readgbin(name, NULL);
+		if(H == NULL || !unit_test_samegraph(G, H, NULL) || H->root == NULL || H->root->id != n / 2) ok = 0;
+		if(H != NULL) free_graph(H);
+		free_graph(G);
+	}
+	fail += unit_test_check(ok, "gbin round trip");
+
+	// the looptree written from the heights is the one of looptree()
+	for(ok=1, n=1; n<=500; n = 3 * n + 1) {
+		G = unit_test_tree(n);
+		G->bfs = bfsorder(G, G->arr[0], 1, 1);
+		L = looptree(G, G->arr[0]);
+		f = fopen(name, "wb");
+		if(f == NULL) {
+			fprintf(stderr, "Error: could not open %s for writing.\n", name);
+			exit(-1);
+		}
+		writeloopgbin(G, NULL, f);
+		fclose(f);
+		H = readgbin(name, NULL);
+		if(H == NULL || !unit_test_samegraph(L, H, NULL)) ok = 0;
+		if(H != NULL) free_graph(H);
+		free_graph(L);
+		free_graph(G);
+	}
+	fail += unit_test_check(ok, "gbin looptree");
+
+	remove(name);
+	return fail;
+}
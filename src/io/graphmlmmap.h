@@ -0,0 +1,510 @@
+/*
+ * Fast path for reading large graphml files
+ *
+ * The file is mapped into memory. We locate the content of the first <graph>
+ * element and split it into chunks of a few megabytes that start with a
+ * <node or <edge tag. The chunks are scanned in parallel by a small
+ * tokenizer that understands start tags, end tags and character data, which
+ * is all that the <node>s and <edge>s of typical graphml files consist of.
+ * The calling thread interns the identifiers of every chunk as soon as it is
+ * done, in the order of the file, so the resulting graph is the same as the
+ * one built by the expat parser. The threads run at most MMAPWINDOW chunks
+ * per thread ahead, hence the tokens take memory in proportion to the number
+ * of threads and not to the number of edges.
+ *
+ * A chunk that was split at a wrong position (inside a nested element) does
+ * not end at depth 0 and gets detected. Whenever the file contains anything
+ * the tokenizer does not handle (comments, CDATA sections or processing
+ * instructions inside the graph, entity references or line breaks in
+ * attribute values, encodings other than UTF-8, ...), mmapgraphml() returns
+ * NULL and the caller falls back to expat.
+ */
+
+
+#define MMAPMINCHUNK (1UL << 22)	// minimal number of bytes per chunk
+#define MMAPWINDOW 2				// chunks per thread that may wait
+
+#define MTOK_NODE 0		// kinds of tokens
+#define MTOK_DIEDGE 1
+#define MTOK_EDGE 2
+#define MTOK_DATA 3		// <data> of the last <node>: key and value
+
+
+// a vertex or an edge found by the tokenizer, the strings point into the
+// mapped file
+struct mtoken {
+	int kind;
+	const char *s;				// identifier or source
+	size_t slen;
+	unsigned long long sh;		// hash value of s
+	const char *t;				// target
+	size_t tlen;
+	unsigned long long th;		// hash value of t
+};
+
+// a part of the content of the <graph> element
+struct mchunk {
+	const char *start;
+	const char *end;
+	int edefault;				// edgedefault (0 = directed, 1 = undirected)
+	struct mtoken *tok;			// vertices and edges in the order of the file
+	INT num;
+	INT cap;
+	long depth;					// depth at the end of the chunk
+	long mindepth;				// minimal depth within the chunk
+	int ok;						// 0 if the chunk needs the expat parser
+	int finished;				// has the chunk been tokenized?
+};
+
+// chunks shared by the tokenizer threads and the interning thread
+struct mjob {
+	struct mchunk *chunks;
+	INT num;					// number of chunks
+	INT next;					// next chunk to tokenize
+	INT done;					// number of interned chunks
+	INT window;					// chunks that may be ahead of done
+	int stop;					// no further chunks are needed
+	pthread_mutex_t mut;
+	pthread_cond_t cond;		// a chunk was tokenized or interned
+};
+
+// the attributes of a start tag that we care about
+struct xtag {
+	const char *name;
+	size_t nlen;
+	int empty;					// tag of the form <name ... />
+	const char *val[7];			// values of id, source, target, directed,
+	size_t vlen[7];				// edgedefault, attr.name and key (NULL if
+								// not present)
+};
+
+const char *xattrnames[7] = {"id", "source", "target", "directed", "edgedefault", "attr.name", "key"};
+
+
+int isxmlspace(char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// compare a string given by pointer and length with a C string
+int xmleq(const char *s, size_t len, const char *lit) {
+	return strlen(lit) == len && memcmp(s, lit, len) == 0;
+}
+
+// first occurrence of the C string lit in p, ..., end-1 (or NULL)
+const char *xmlfind(const char *p, const char *end, const char *lit) {
+	size_t len = strlen(lit);
+
+	for(; p != NULL && end - p >= (long) len; p++) {
+		p = memchr(p, lit[0], end - p - len + 1);
+		if(p == NULL) break;
+		if(memcmp(p, lit, len) == 0) return p;
+	}
+
+	return NULL;
+}
+
+
+/*
+ * Parses the start tag at p (which points to '<'). Returns the position
+ * after the tag, or NULL if the tag is malformed or needs expat.
+ */
+const char *xmlstarttag(const char *p, const char *end, struct xtag *tag) {
+	const char *n, *v, *q;
+	size_t nlen;
+	char quote;
+	int i;
+
+	for(i=0; i<7; i++)
+		tag->val[i] = NULL;
+
+	p++;
+	tag->name = p;
+	while(p < end && !isxmlspace(*p) && *p != '/' && *p != '>') p++;
+	tag->nlen = p - tag->name;
+	if(tag->nlen == 0) return NULL;
+
+	while(1) {
+		while(p < end && isxmlspace(*p)) p++;
+		if(p >= end) return NULL;
+
+		if(*p == '>') {
+			tag->empty = 0;
+			return p + 1;
+		}
+		if(*p == '/') {
+			if(p + 1 >= end || p[1] != '>') return NULL;
+			tag->empty = 1;
+			return p + 2;
+		}
+
+		// attribute name = value
+		n = p;
+		while(p < end && !isxmlspace(*p) && *p != '=' && *p != '>' && *p != '/') p++;
+		nlen = p - n;
+		while(p < end && isxmlspace(*p)) p++;
+		if(nlen == 0 || p >= end || *p != '=') return NULL;
+		p++;
+		while(p < end && isxmlspace(*p)) p++;
+		if(p >= end || (*p != '"' && *p != '\'')) return NULL;
+		quote = *p++;
+		v = p;
+		q = memchr(p, quote, end - p);
+		if(q == NULL) return NULL;
+
+		// values with entity references or line breaks need expat
+		for(; p < q; p++)
+			if(*p == '&' || *p == '<' || *p == '\t' || *p == '\n' || *p == '\r') return NULL;
+		p = q + 1;
+
+		for(i=0; i<7; i++) {
+			if(xmleq(n, nlen, xattrnames[i])) {
+				tag->val[i] = v;
+				tag->vlen[i] = q - v;
+			}
+		}
+	}
+}
+
+
+void pushmtoken(struct mchunk *c, int kind, const char *s, size_t slen, const char *t, size_t tlen) {
+	if(c->num == c->cap) {
+		c->cap = (c->cap == 0) ? 1024 : 2 * c->cap;
+		c->tok = (struct mtoken *) realloc(c->tok, c->cap * sizeof(struct mtoken));
+		if(c->tok == NULL) {
+			fprintf(stderr, "Memory allocation error in function pushmtoken.\n");
+			exit(-1);
+		}
+	}
+	c->tok[c->num].kind = kind;
+	c->tok[c->num].s = s;
+	c->tok[c->num].slen = slen;
+	c->tok[c->num].sh = djb2hash(s, slen);
+	c->tok[c->num].t = t;
+	c->tok[c->num].tlen = tlen;
+	c->tok[c->num].th = (t != NULL) ? djb2hash(t, tlen) : 0;
+	c->num++;
+}
+
+
+// thread that tokenizes one chunk
+void *mmapchunk(void *arg) {
+	struct mchunk *c = (struct mchunk *) arg;
+	const char *p = c->start, *end = c->end, *q;
+	struct xtag tag;
+	int undirected, innode;
+
+	c->ok = 0;
+	c->depth = 0;
+	c->mindepth = 0;
+	innode = 0;
+
+	while(p < end) {
+		p = memchr(p, '<', end - p);
+		if(p == NULL) break;
+		if(p + 1 >= end || p[1] == '!' || p[1] == '?') return NULL;
+
+		if(p[1] == '/') {
+			// end tag
+			q = memchr(p, '>', end - p);
+			if(q == NULL) return NULL;
+			c->depth--;
+			if(c->depth < c->mindepth) c->mindepth = c->depth;
+			if(c->depth == 0) innode = 0;
+			p = q + 1;
+			continue;
+		}
+
+		p = xmlstarttag(p, end, &tag);
+		if(p == NULL) return NULL;
+
+		// vertices and edges of the graph itself
+		if(c->depth == 0) {
+			if(xmleq(tag.name, tag.nlen, "node")) {
+				if(tag.val[0] != NULL) pushmtoken(c, MTOK_NODE, tag.val[0], tag.vlen[0], NULL, 0);
+				innode = !tag.empty;
+			} else if(xmleq(tag.name, tag.nlen, "edge")) {
+				// let expat report the error
+				if(tag.val[1] == NULL || tag.val[2] == NULL) return NULL;
+
+				undirected = c->edefault;
+				if(tag.val[3] != NULL) {
+					if(xmleq(tag.val[3], tag.vlen[3], "true")) undirected = 0;
+					else if(xmleq(tag.val[3], tag.vlen[3], "false")) undirected = 1;
+				}
+				pushmtoken(c, undirected ? MTOK_EDGE : MTOK_DIEDGE, tag.val[1], tag.vlen[1], tag.val[2], tag.vlen[2]);
+			}
+		}
+
+		// attributes of a vertex, the value is the character data up to the
+		// next tag
+		if(c->depth == 1 && innode && !tag.empty && tag.val[6] != NULL && xmleq(tag.name, tag.nlen, "data")) {
+			q = memchr(p, '<', end - p);
+			if(q == NULL || memchr(p, '&', q - p) != NULL) return NULL;
+			pushmtoken(c, MTOK_DATA, tag.val[6], tag.vlen[6], p, q - p);
+		}
+
+		if(!tag.empty) c->depth++;
+	}
+
+	c->ok = 1;
+	return NULL;
+}
+
+
+// tokenizer thread: tokenize chunks while the window allows it
+void *mmapworker(void *arg) {
+	struct mjob *J = (struct mjob *) arg;
+	INT k;
+
+	while(1) {
+		pthread_mutex_lock(&J->mut);
+		while(!J->stop && J->next < J->num && J->next >= J->done + J->window)
+			pthread_cond_wait(&J->cond, &J->mut);
+		if(J->stop || J->next == J->num) {
+			pthread_mutex_unlock(&J->mut);
+			break;
+		}
+		k = J->next++;
+		pthread_mutex_unlock(&J->mut);
+
+		mmapchunk(&J->chunks[k]);
+
+		pthread_mutex_lock(&J->mut);
+		J->chunks[k].finished = 1;
+		pthread_cond_broadcast(&J->cond);
+		pthread_mutex_unlock(&J->mut);
+	}
+
+	return NULL;
+}
+
+
+// interns the vertices, edges and attributes of a tokenized chunk
+void mmapintern(struct graphbuilder *B, struct mchunk *c) {
+	struct mtoken *t;
+	INT i;
+
+	for(i=0; i<c->num; i++) {
+		t = &c->tok[i];
+		if(t->kind == MTOK_NODE) {
+			gbnodehash(B, t->s, t->slen, t->sh);
+		} else if(t->kind == MTOK_DATA) {
+			gbdata(B, t->s, t->slen, t->t, t->tlen);
+		} else {
+			gbdiedgehash(B, t->s, t->slen, t->sh, t->t, t->tlen, t->th);
+			if(t->kind == MTOK_EDGE) gbdiedgehash(B, t->t, t->tlen, t->th, t->s, t->slen, t->sh);
+		}
+	}
+}
+
+
+/*
+ * Scans the markup outside of the first <graph> element. If graph is
+ * nonzero, the scan starts at the beginning of the document and stops after
+ * the start tag of the first <graph> at depth 1, the value of its attribute
+ * edgedefault is stored in *edefault. Otherwise the scan starts at depth 1
+ * after the end tag of this <graph> and has to reach the end of the
+ * document. The <key>s found at depth 1 are declared to B (if not NULL).
+ * Returns the position where the scan stopped or NULL if the document needs
+ * expat.
+ */
+const char *mmapouter(const char *p, const char *end, int graph, int *edefault, struct graphbuilder *B) {
+	const char *q, *enc;
+	struct xtag tag;
+	long depth = graph ? 0 : 1;
+
+	// skip a byte order mark
+	if(graph && end - p >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0) p += 3;
+
+	while(p < end) {
+		// character data outside of the root element has to be white space
+		if(depth == 0) {
+			while(p < end && isxmlspace(*p)) p++;
+			if(p >= end) break;
+			if(*p != '<') return NULL;
+		} else {
+			p = memchr(p, '<', end - p);
+			if(p == NULL) return NULL;
+		}
+		if(p + 1 >= end) return NULL;
+
+		if(p[1] == '?') {
+			q = xmlfind(p, end, "?>");
+			if(q == NULL) return NULL;
+			// only UTF-8 (and its subset ASCII) is read directly
+			enc = xmlfind(p, q, "encoding");
+			if(enc != NULL && xmlfind(enc, q, "UTF-8") == NULL && xmlfind(enc, q, "utf-8") == NULL && xmlfind(enc, q, "ASCII") == NULL && xmlfind(enc, q, "ascii") == NULL) return NULL;
+			p = q + 2;
+		} else if(p[1] == '!') {
+			if(end - p < 4 || memcmp(p, "<!--", 4) != 0) return NULL;
+			q = xmlfind(p + 4, end, "-->");
+			if(q == NULL) return NULL;
+			p = q + 3;
+		} else if(p[1] == '/') {
+			q = memchr(p, '>', end - p);
+			if(q == NULL || depth == 0) return NULL;
+			depth--;
+			p = q + 1;
+		} else {
+			// a second root element
+			if(depth == 0 && !graph) return NULL;
+
+			p = xmlstarttag(p, end, &tag);
+			if(p == NULL) return NULL;
+			if(graph && depth == 1 && xmleq(tag.name, tag.nlen, "graph")) {
+				if(tag.empty) return NULL;
+				*edefault = (tag.val[4] != NULL && xmleq(tag.val[4], tag.vlen[4], "undirected"));
+				return p;
+			}
+			if(B != NULL && depth == 1 && xmleq(tag.name, tag.nlen, "key") && tag.val[0] != NULL && tag.val[5] != NULL)
+				gbkey(B, tag.val[0], tag.vlen[0], tag.val[5], tag.vlen[5]);
+			if(!tag.empty) depth++;
+		}
+	}
+
+	return (graph || depth != 0) ? NULL : p;
+}
+
+
+/*
+ * Reads the graph from a graphml file using numThreads threads. Returns NULL
+ * if the file cannot be mapped or the document needs the expat parser.
+ */
+struct graph *mmapgraphml(char *infile, struct roots *R, INT numThreads) {
+#ifdef _WIN32
+	return NULL;
+#else
+	FILE *f;
+	int edefault;
+	off_t size;
+	const char *map, *end, *rs, *re, *p;
+	struct mchunk *chunks, *c;
+	struct mjob J;
+	struct graphbuilder B;
+	struct graph *G;
+	pthread_t *th;
+	INT k, n, nt, len;
+	int ok;
+
+	if(infile == NULL || numThreads < 1) return NULL;
+
+	// pipes and other streams cannot be mapped
+	f = fopen(infile, "r");
+	if(f == NULL) return NULL;
+	size = lseek(fileno(f), 0, SEEK_END);
+	map = (size > 0) ? (const char *) mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(f), 0) : MAP_FAILED;
+	fclose(f);
+	if(map == MAP_FAILED) return NULL;
+	end = map + size;
+
+	/* content of the first <graph>: from its start tag to the last </graph> */
+	gbinit(&B);
+	rs = mmapouter(map, end, 1, &edefault, &B);
+	re = NULL;
+	for(p = end; rs != NULL && p - rs >= 8; p--) {
+		if(memcmp(p - 8, "</graph", 7) == 0 && (p[-1] == '>' || isxmlspace(p[-1]))) {
+			re = p - 8;
+			break;
+		}
+	}
+	if(rs == NULL || re == NULL) {
+		gbfree(&B);
+		munmap((void *) map, size);
+		return NULL;
+	}
+	p = memchr(re, '>', end - re);
+	if(p == NULL || mmapouter(p + 1, end, 0, NULL, NULL) == NULL) {
+		gbfree(&B);
+		munmap((void *) map, size);
+		return NULL;
+	}
+
+	/* split into chunks that start with a <node or <edge tag */
+	len = re - rs;
+	n = len / MMAPMINCHUNK;
+	if(n < 1) n = 1;
+	nt = (n < numThreads) ? n : numThreads;
+
+	chunks = (struct mchunk *) calloc(n, sizeof(struct mchunk));
+	th = (pthread_t *) calloc(nt, sizeof(pthread_t));
+	if(chunks == NULL || th == NULL) {
+		fprintf(stderr, "Memory allocation error in function mmapgraphml.\n");
+		exit(-1);
+	}
+	for(k=0; k<n; k++) {
+		p = (k == 0) ? rs : rs + k * (len / n);
+		if(k > 0 && p < chunks[k-1].start) p = chunks[k-1].start;
+		while(k > 0 && p < re) {
+			p = memchr(p, '<', re - p);
+			if(p == NULL) {
+				p = re;
+				break;
+			}
+			if(re - p > 5 && (memcmp(p, "<node", 5) == 0 || memcmp(p, "<edge", 5) == 0) && (isxmlspace(p[5]) || p[5] == '/' || p[5] == '>')) break;
+			p++;
+		}
+		chunks[k].start = p;
+		chunks[k].edefault = edefault;
+		if(k > 0) chunks[k-1].end = p;
+	}
+	chunks[n-1].end = re;
+
+	/* tokenize in parallel */
+	J.chunks = chunks;
+	J.num = n;
+	J.next = 0;
+	J.done = 0;
+	J.window = MMAPWINDOW * nt;
+	J.stop = 0;
+	pthread_mutex_init(&J.mut, NULL);
+	pthread_cond_init(&J.cond, NULL);
+	for(k=0; k<nt; k++) {
+		if(pthread_create(&th[k], NULL, &mmapworker, &J)) {
+			fprintf(stderr, "Error launching thread number %"STR(FINT)"\n", k);
+			exit(-1);
+		}
+	}
+
+	/* intern identifiers in the order of the file */
+	// every chunk has to start and end at depth 0 of the <graph>
+	for(ok=1, k=0; k<n && ok; k++) {
+		c = &chunks[k];
+		pthread_mutex_lock(&J.mut);
+		while(!c->finished)
+			pthread_cond_wait(&J.cond, &J.mut);
+		pthread_mutex_unlock(&J.mut);
+
+		if(!c->ok || c->depth != 0 || c->mindepth < 0) ok = 0;
+		else mmapintern(&B, c);
+		free(c->tok);
+		c->tok = NULL;
+
+		pthread_mutex_lock(&J.mut);
+		J.done = k + 1;
+		pthread_cond_broadcast(&J.cond);
+		pthread_mutex_unlock(&J.mut);
+	}
+
+	pthread_mutex_lock(&J.mut);
+	J.stop = 1;
+	pthread_cond_broadcast(&J.cond);
+	pthread_mutex_unlock(&J.mut);
+	for(k=0; k<nt; k++)
+		pthread_join(th[k], NULL);
+	pthread_mutex_destroy(&J.mut);
+	pthread_cond_destroy(&J.cond);
+
+	for(k=0; k<n; k++)
+		if(chunks[k].tok != NULL) free(chunks[k].tok);
+	free(chunks);
+	free(th);
+
+	G = NULL;
+
+	if(ok) G = gbgraph(&B, R);
+	else gbfree(&B);
+	munmap((void *) map, size);
+
+	return G;
+#endif
+}
@@ -16,7 +16,7 @@ In accordance with these rules, this parser takes only the first <graph> object
 
 // the status of the parser
 struct pstat {
-	struct strgraph *H; // temporary storage for vertices and edges
+	struct graphbuilder *B; // collects vertices and edges
 	int depth;			// depth of current element
 	int numgraph;		// how many graph objects at depth 1
 	int edefault;		// edgedefault (0 = directed, 1 = undirected)
@@ -33,124 +33,13 @@ struct pstat {
 	const char *str_source;
 	const char *str_target;
 	const char *str_id;
+	int innode;			// inside a <node> of the graph?
+	char *key;			// key of the current <data> element (or NULL)
+	char *text;			// its character data
+	size_t tlen;
+	size_t tcap;
 };
 
-void pushvertex(struct strgraph *H, const char *ident) {
-	struct vlist *v;
-
-	// build new list entry
-	v = (struct vlist *) malloc(sizeof(struct vlist));
-	if(v == NULL) {
-		fprintf(stderr, "Error allocating memory for temporary graph structure");
-		exit(-1);
-	}
-	v->next = NULL;
-
-	// set string identifier of vertex
-	v->ident = (char *) malloc(sizeof(char)*(strlen(ident) + 1));
-	if(v->ident == NULL) {
-		fprintf(stderr, "Error allocating memory for temporary graph structure");
-		exit(-1);
-	}
-	strcpy(v->ident, ident);
-
-	
-
-	// set id and insert vertex in list
-	if(H->vstart == NULL) {
-		v->id = 0;		// vertex is the first in the list
-		H->vstart = v;
-		H->vend = v;
-	} else {
-		v->id = H->vend->id +1;
-		H->vend->next = v;
-		H->vend = v;
-	}
-}
-
-void pushdiedge(struct strgraph *H, const char *source, const char *target) {
-	struct elist *e;
-
-	// build new list entry
-	e = (struct elist *) malloc(sizeof(struct elist));
-	if(e == NULL) {
-		fprintf(stderr, "Error allocating memory for temporary graph structure");
-		exit(-1);
-	}
-
-	// set source, target, and id of edge
-	e->source = (char *) malloc(sizeof(char)*(strlen(source) + 1));
-	e->target = (char *) malloc(sizeof(char)*(strlen(target) + 1));
-	if(e->source == NULL || e->target == NULL) {
-		fprintf(stderr, "Error allocating memory for temporary graph structure");
-		exit(-1);
-	}
-	strcpy(e->source, source);
-	strcpy(e->target, target);
-
-	e->next = NULL;
-	
-
-	// insert vertex in list
-	if(H->estart == NULL) {
-		H->estart = e;
-		H->eend = e;
-	} else {
-		H->eend->next = e;
-		H->eend = e;
-	}
-
-	
-}
-
-void pushedge(struct strgraph *H, const char *source, const char *target) {
-	pushdiedge(H, source, target);
-	pushdiedge(H, target, source);
-}
-
-void print_strgraph(struct strgraph *H) {
-	struct vlist *v;
-	struct elist *e;
-
-	printf("Vertices: \n");
-	v =  H->vstart;
-	while(v) {
-		printf("%"STR(FINT)" - \t%s\n", v->id, v->ident);
-		v = v->next;
-	}
-
-	printf("Edges: \n");
-	e =  H->estart;
-	while(e) {
-		printf("\t%s -> %s\n", e->source, e->target);
-		e = e->next;
-	}
-}
-
-void free_strgraph(struct strgraph *H) {
-	struct vlist *v, *tmpv;
-	struct elist *e, *tmpe;
-
-	v = H->vstart;
-	while(v) {
-		tmpv = v->next;
-		free(v->ident);
-		free(v);
-		v = tmpv;
-	}
-	
-	e = H->estart;
-	while(e) {
-		tmpe = e->next;
-		free(e->source);
-		free(e->target);
-		free(e);
-		e = tmpe;
-	}
-
-	free(H);
-}
-
 static void XMLCALL start(void *data, const char *el, const char **attr)
 {
 	int i;
@@ -189,20 +78,45 @@ static void XMLCALL start(void *data, const char *el, const char **attr)
 
 			// add directed edge or undirected edge
 			if(undirected == 1) {
-				pushedge(mydata->H, source, target);
+				gbedge(mydata->B, source, strlen(source), target, strlen(target));
 			} else {
-				pushdiedge(mydata->H, source, target);
+				gbdiedge(mydata->B, source, strlen(source), target, strlen(target));
 			}
 		} else if ( strcmp(el, mydata->str_node) == 0 ) {
 			// check for id
 			for (i = 0; attr[i]; i += 2) {
 				if( strcmp(attr[i], mydata->str_id) == 0 ) {
-					pushvertex(mydata->H, attr[i+1]);
+					gbnode(mydata->B, attr[i+1], strlen(attr[i+1]));
 				}
 			}
+			mydata->innode = 1;
 		}
 	} 
 
+	// attributes of the vertices: <key>s at depth 1, <data> within <node>s
+	if( (mydata->depth == 1) && (strcmp(el, "key") == 0) ) {
+		source = NULL;
+		target = NULL;
+		for (i = 0; attr[i]; i += 2) {
+			if( strcmp(attr[i], mydata->str_id) == 0 ) source = attr[i+1];
+			else if( strcmp(attr[i], "attr.name") == 0 ) target = attr[i+1];
+		}
+		if(source != NULL && target != NULL)
+			gbkey(mydata->B, source, strlen(source), target, strlen(target));
+	}
+	if( (mydata->depth == 3) && mydata->innode && (strcmp(el, "data") == 0) ) {
+		for (i = 0; attr[i]; i += 2) {
+			if( strcmp(attr[i], "key") == 0 ) {
+				mydata->key = strdup(attr[i+1]);
+				mydata->tlen = 0;
+				if(mydata->key == NULL) {
+					fprintf(stderr, "Memory allocation error in function start.\n");
+					exit(-1);
+				}
+			}
+		}
+	}
+
 	// increment number of <graph>s at depth level 1	
 	if( (mydata->depth == 1) && (strcmp(el, mydata->str_graph) == 0) ) {
 		mydata->numgraph++;
@@ -225,18 +139,52 @@ static void XMLCALL end(void *data, const char *el)
 	struct pstat *mydata = (struct pstat *)data;
 
 	mydata->depth--;
+
+	if( (mydata->depth == 3) && (mydata->key != NULL) ) {
+		gbdata(mydata->B, mydata->key, strlen(mydata->key), mydata->text, mydata->tlen);
+		free(mydata->key);
+		mydata->key = NULL;
+	}
+	if(mydata->depth == 2) mydata->innode = 0;
+}
+
+// collects the character data of <data> elements
+static void XMLCALL chardata(void *data, const char *s, int len)
+{
+	struct pstat *mydata = (struct pstat *)data;
+
+	if(mydata->key == NULL || len <= 0) return;
+
+	if(mydata->tlen + len > mydata->tcap) {
+		mydata->tcap = 2 * (mydata->tlen + len);
+		mydata->text = (char *) realloc(mydata->text, mydata->tcap);
+		if(mydata->text == NULL) {
+			fprintf(stderr, "Memory allocation error in function chardata.\n");
+			exit(-1);
+		}
+	}
+	memcpy(mydata->text + mydata->tlen, s, len);
+	mydata->tlen += len;
 }
 
 
 // should also add functionality to read from file instead of stdin
 // struct graph *parsegraphml(FILE *fpointer)
-struct graph *parsegraphml(char *infile, char *rootid)
+struct graph *parsegraphml(char *infile, struct roots *R, INT numThreads)
 {
 	char Buff[8192];
 	int done;
 	int len;
 	FILE *instream;
 	struct graph *G;
+	struct graphbuilder B;
+
+	// large files are read by the memory mapped parser if possible,
+	// compressed files are decompressed while they are parsed by expat
+	if(inputcompression(infile) == ZNONE) {
+		G = mmapgraphml(infile, R, numThreads);
+		if(G != NULL) return G;
+	}
 
 	struct pstat status = {
 		NULL,
@@ -254,19 +202,17 @@ struct graph *parsegraphml(char *infile, char *rootid)
 		"false",
 		"source",
 		"target",
-		"id"
+		"id",
+		0,
+		NULL,
+		NULL,
+		0,
+		0
 	};
 						;
 
-	status.H = (struct strgraph *) malloc(sizeof(struct strgraph));
-	if(status.H == NULL) {
-		fprintf(stderr, "Couldn't allocate memory for parser\n");
-		exit(-1);
-	}
-	status.H->vstart=NULL;
-	status.H->vend=NULL;
-	status.H->estart=NULL;
-	status.H->eend=NULL;
+	gbinit(&B);
+	status.B = &B;
 
 
 	XML_Parser parser = XML_ParserCreate(NULL);
@@ -280,7 +226,7 @@ struct graph *parsegraphml(char *infile, char *rootid)
 	if(infile == NULL) {
 		instream = stdin;
 	} else {
-		instream = fopen(infile, "r");
+		instream = openinput(infile);
 		if(instream == NULL) {
 			fprintf(stderr, "Error opening input file.\n");
 			exit(-1);
@@ -293,6 +239,7 @@ struct graph *parsegraphml(char *infile, char *rootid)
 	// the address of pstat is passed to these functions in those events
 	XML_SetUserData(parser, &status);
 	XML_SetElementHandler(parser, start, end);
+	XML_SetCharacterDataHandler(parser, chardata);
 
 	while(1) {
 		len = (int)fread(Buff, 1, 8192, instream);
@@ -313,24 +260,21 @@ struct graph *parsegraphml(char *infile, char *rootid)
 	}
 
 	XML_ParserFree(parser);
+	if(status.key != NULL) free(status.key);
+	if(status.text != NULL) free(status.text);
 
 
 	// close input file if necessary
-	if(infile != NULL) fclose(instream);
+	if(infile != NULL) closestream(instream);
 
 	/*
-	 * At this point, status.H is a pointer to a temporary graph structure
-	 * that holds a list of vertex identifiers (strings) and edges (pairs 
-	 * of strings).
-	 *
-	 * The following builds a more efficient graph structure.
-	 * (I guess this could still be improved a lot by making it
-	 * cache-friendly. I still have much to learn... :-) )
+	 * At this point, the builder holds the interned vertex identifiers
+	 * and the edges as pairs of symbols. The following sorts the edges
+	 * into a compressed sparse row structure and builds the graph from it.
 	 */
-	G = make_graph(status.H, rootid);	// recall that some edges of H may point to
- 								// nowhere, if an endpoint lies in a 
- 								// nested <graph>
-	free_strgraph(status.H);
+	G = gbgraph(&B, R);	// recall that some edges may point to
+								// nowhere, if an endpoint lies in a 
+								// nested <graph>
 	return G;
 
 }
@@ -0,0 +1,160 @@
+/*
+ * Merge partial sequence files
+ *
+ * Jobs that computed the closeness centrality of disjoint vertex ranges
+ * (see --cent-range) write one sequence {x, y, z} each. We stitch these
+ * sequences together in the order in which the files are given. Partial
+ * lists written as NumPy arrays are merged into one array.
+ */
+
+
+/*
+ * Copy the entries of the sequence in file infile to outstream
+ * Returns the number of copied characters
+ */
+long copyseq(char *infile, FILE *outstream, int sep) {
+	FILE *instream;
+	int c;
+	long cnt;
+
+	instream = openinput(infile);
+	if(instream == NULL) {
+		fprintf(stderr, "Error opening input file %s.\n", infile);
+		exit(-1);
+	}
+
+	// skip to the opening brace
+	while( (c = fgetc(instream)) != EOF && c != '{' );
+	if(c == EOF) {
+		fprintf(stderr, "Error: %s does not contain a sequence.\n", infile);
+		exit(-1);
+	}
+
+	// copy the entries
+	for(cnt=0; (c = fgetc(instream)) != EOF && c != '}'; cnt++) {
+		if(cnt == 0 && sep) fprintf(outstream, ", ");
+		fputc(c, outstream);
+	}
+	if(c == EOF) {
+		fprintf(stderr, "Error: sequence in %s is incomplete.\n", infile);
+		exit(-1);
+	}
+
+	// there must not be a second sequence
+	while( (c = fgetc(instream)) != EOF ) {
+		if(c == '{') {
+			fprintf(stderr, "Error: %s contains more than one sequence.\n", infile);
+			exit(-1);
+		}
+	}
+
+	closestream(instream);
+
+	return cnt;
+}
+
+
+/*
+ * Write the concatenation of the arrays in the .npy files infiles[0], ...,
+ * infiles[num-1] to the .npy file outfile
+ */
+int mergenpy(char **infiles, int num, char *outfile) {
+	FILE *outstream;
+	struct obuf O;
+	const char **maps;
+	size_t *lens, *offs;
+	int *mapped, i, type, t;
+	INT n, total;
+
+	maps = (const char **) calloc(num, sizeof(const char *));
+	lens = (size_t *) calloc(num, sizeof(size_t));
+	offs = (size_t *) calloc(num, sizeof(size_t));
+	mapped = (int *) calloc(num, sizeof(int));
+	if(maps == NULL || lens == NULL || offs == NULL || mapped == NULL) {
+		fprintf(stderr, "Memory allocation error in function mergenpy.\n");
+		exit(-1);
+	}
+
+	// the arrays must have the same type and fill their files
+	type = 0;
+	for(i=0, total=0; i<num; i++) {
+		maps[i] = mapinput(infiles[i], &lens[i], &mapped[i]);
+		offs[i] = npyparse(maps[i], lens[i], &t, &n);
+		if(offs[i] == 0) {
+			fprintf(stderr, "Error: %s does not contain a NumPy array.\n", infiles[i]);
+			exit(-1);
+		}
+		if(type != 0 && t != type) {
+			fprintf(stderr, "Error: the arrays in %s and %s have different types.\n", infiles[0], infiles[i]);
+			exit(-1);
+		}
+		if(lens[i] - offs[i] != n * 8) {
+			fprintf(stderr, "Error: %s is truncated or contains more than one array.\n", infiles[i]);
+			exit(-1);
+		}
+		type = t;
+		total += n;
+	}
+
+	outstream = openoutput(outfile, "a");
+	if(outstream == NULL) {
+		fprintf(stderr, "Error opening output file %s.\n", outfile);
+		exit(-1);
+	}
+	obopen(&O, outstream);
+	npyheader(&O, type, total);
+	for(i=0; i<num; i++) {
+		obwrite(&O, maps[i] + offs[i], lens[i] - offs[i]);
+		unmapinput(maps[i], lens[i], mapped[i]);
+	}
+	obclose(&O);
+	closestream(outstream);
+
+	free(maps);
+	free(lens);
+	free(offs);
+	free(mapped);
+
+	return 0;
+}
+
+
+/*
+ * Write the concatenation of the sequences in the files infiles[0], ...,
+ * infiles[num-1] to outfile
+ */
+int mergeseq(char **infiles, int num, char *outfile) {
+	FILE *outstream;
+	char magic[6];
+	int i, sep;
+
+	if(isnpy(outfile)) return mergenpy(infiles, num, outfile);
+	for(i=0; i<num; i++) {
+		if(inputhead(infiles[i], magic, 6) == 6 && memcmp(magic, "\x93NUMPY", 6) == 0) {
+			fprintf(stderr, "Error: %s is a NumPy array, the merged list needs a CENTFILE ending in .npy.\n", infiles[i]);
+			exit(-1);
+		}
+	}
+
+	// open output file if necessary
+	if(outfile == NULL || strlen(outfile) == 0) {
+		outstream = stdout;
+	} else {
+		outstream = openoutput(outfile, "a");
+		if(outstream == NULL) {
+			fprintf(stderr, "Error opening output file %s.\n", outfile);
+			exit(-1);
+		}
+	}
+
+	fprintf(outstream, "{");
+	for(i=0, sep=0; i<num; i++) {
+		if(copyseq(infiles[i], outstream, sep) > 0) sep = 1;
+	}
+	fprintf(outstream, "}\n");
+
+	// close file if necessary
+	if(outfile != NULL) closestream(outstream);
+
+	return 0;
+}
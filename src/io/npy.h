@@ -0,0 +1,144 @@
+/*
+ * NumPy array output (.npy)
+ *
+ * Sequences written to a file whose name ends in .npy (possibly followed by
+ * .gz or .zst) are stored as one-dimensional NumPy arrays instead of text
+ * (the decimated paths as arrays with three columns):
+ * integers as unsigned 64 bit integers and floating point values as doubles,
+ * in the byte order of the machine. Analysis code can load or memory-map
+ * such files without any parsing:
+ *
+ *		np.load("hei.npy", mmap_mode="r")
+ *
+ * Every output appends a complete array to the file, so an aggregated file
+ * of --num samples holds one array per sample; np.load() called repeatedly on
+ * the same open file returns them one after the other.
+ *
+ * Format version 1.0: the magic string "\x93NUMPY", the version bytes 1 and
+ * 0, the length of the header as little endian uint16 and the header, a
+ * Python dictionary padded with spaces and a newline such that the data
+ * starts at a multiple of 64 bytes.
+ */
+
+
+#define NPYALIGN 64
+
+#define NPYUINT 1
+#define NPYDOUBLE 2
+
+
+// is outfile a NumPy file?
+int isnpy(const char *outfile) {
+	return hassuffix(outfile, ".npy") || hassuffix(outfile, ".npy.gz") || hassuffix(outfile, ".npy.zst");
+}
+
+
+/*
+ * Header of an array with n rows of cols entries of the given type, stored
+ * row by row. The array is one-dimensional if cols is 0.
+ */
+void npymatrix(struct obuf *O, int type, INT n, INT cols) {
+	char dict[128], shape[64];
+	unsigned char pre[10];
+	uint16_t one = 1;
+	int len, pad;
+
+	if(cols == 0) snprintf(shape, sizeof(shape), "(%"STR(FINT)",)", n);
+	else snprintf(shape, sizeof(shape), "(%"STR(FINT)", %"STR(FINT)")", n, cols);
+
+	// '<' or '>' for little or big endian
+	len = snprintf(dict, sizeof(dict), "{'descr': '%c%s', 'fortran_order': False, 'shape': %s, }",
+		(*(unsigned char *) &one == 1) ? '<' : '>', (type == NPYDOUBLE) ? "f8" : "u8", shape);
+	pad = NPYALIGN - (10 + len + 1) % NPYALIGN;
+	if(pad == NPYALIGN) pad = 0;
+
+	memcpy(pre, "\x93NUMPY", 6);
+	pre[6] = 1;
+	pre[7] = 0;
+	pre[8] = (unsigned char) ((len + pad + 1) & 0xff);
+	pre[9] = (unsigned char) ((len + pad + 1) >> 8);
+
+	obwrite(O, (char *) pre, 10);
+	obwrite(O, dict, len);
+	for(; pad > 0; pad--)
+		obwrite(O, " ", 1);
+	obwrite(O, "\n", 1);
+}
+
+// header of a one-dimensional array with n entries of the given type
+void npyheader(struct obuf *O, int type, INT n) {
+	npymatrix(O, type, n, 0);
+}
+
+
+/*
+ * Checks that map holds the header of a one-dimensional array written by
+ * npyheader() on a machine with the same byte order, sets its type and its
+ * number of entries n. Returns the offset of the data, or 0 if it is no
+ * such array.
+ */
+size_t npyparse(const char *map, size_t len, int *type, INT *n) {
+	uint16_t one = 1;
+	size_t hl;
+	char *dict, *p, order;
+
+	if(len < 10 || memcmp(map, "\x93NUMPY", 6) != 0 || map[6] != 1) return 0;
+	hl = (unsigned char) map[8] | ((size_t) (unsigned char) map[9] << 8);
+	if(len < 10 + hl) return 0;
+
+	dict = (char *) malloc(hl + 1);
+	if(dict == NULL) {
+		fprintf(stderr, "Memory allocation error in function npyparse.\n");
+		exit(-1);
+	}
+	memcpy(dict, map + 10, hl);
+	dict[hl] = '\0';
+
+	order = (*(unsigned char *) &one == 1) ? '<' : '>';
+	*type = 0;
+	p = strstr(dict, "'descr': '");
+	if(p != NULL && p[10] == order && p[11] != '\0' && p[12] == '8') {
+		if(p[11] == 'u') *type = NPYUINT;
+		if(p[11] == 'f') *type = NPYDOUBLE;
+	}
+	p = strstr(dict, "'shape': (");
+	if(p != NULL) *n = (INT) strtoull(p + 10, &p, 10);
+	if(*type == 0 || p == NULL || strncmp(p, ",)", 2) != 0 || strstr(dict, "'fortran_order': False") == NULL) {
+		free(dict);
+		return 0;
+	}
+	free(dict);
+
+	return 10 + hl;
+}
+
+
+void npyputu(struct obuf *O, uint64_t x) {
+	obwrite(O, (char *) &x, sizeof(uint64_t));
+}
+
+void npyputd(struct obuf *O, double x) {
+	obwrite(O, (char *) &x, sizeof(double));
+}
+
+
+// entry i of a sequence as a binary array element
+void degbin(struct obuf *B, INT i, void *ctx) {
+	npyputu(B, ((struct graph *) ctx)->arr[i]->deg);
+}
+
+void heightbin(struct obuf *B, INT i, void *ctx) {
+	npyputu(B, ((struct graph *) ctx)->arr[i]->height);
+}
+
+void intbin(struct obuf *B, INT i, void *ctx) {
+	npyputu(B, ((INT *) ctx)[i]);
+}
+
+void intdbin(struct obuf *B, INT i, void *ctx) {
+	npyputu(B, ((INTD *) ctx)[i]);
+}
+
+void doublebin(struct obuf *B, INT i, void *ctx) {
+	npyputd(B, (double) ((DOUBLE *) ctx)[i]);
+}
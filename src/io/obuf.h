@@ -0,0 +1,272 @@
+/*
+ * Buffered text output
+ *
+ * Sequences with millions of entries spend most of their output time in
+ * fprintf. The functions below collect the text in a large buffer and
+ * convert numbers to text by hand. The output is byte for byte the same as
+ * with the printf formats used before ("%lu", "%llu", "%17.17f" and
+ * "%17.17Lf").
+ *
+ * Long sequences are formatted by several threads: every thread formats a
+ * block of consecutive entries into a buffer of its own and the blocks are
+ * written in order afterwards.
+ *
+ * Usage:
+ *		obopen(&O, outstream);
+ *		obputs(&O, "{");
+ *		obformat(&O, n, &item, ctx);	// item(&B, i, ctx) for i < n
+ *		obputs(&O, "}\n");
+ *		obclose(&O);					// flushes, does not close the file
+ */
+
+
+#define OBUFSIZE (1UL << 22)	// size of the write buffer
+#define OBITEMS (1UL << 15)		// number of entries per thread and block
+#define OBPREC 17				// number of decimals of floating point values
+#define OBSCALE 100000000000000000ULL	// 10^OBPREC
+
+
+// number of threads that format long outputs, set in main()
+INT outthreads = 1;
+
+
+struct obuf {
+	FILE *f;		// NULL for buffers that only live in memory
+	char *buf;
+	size_t len;
+	size_t cap;
+};
+
+
+void obinit(struct obuf *O, FILE *f, size_t cap) {
+	O->f = f;
+	O->len = 0;
+	O->cap = cap;
+	O->buf = (char *) malloc(cap);
+	if(O->buf == NULL) {
+		fprintf(stderr, "Memory allocation error in function obinit.\n");
+		exit(-1);
+	}
+}
+
+
+void obopen(struct obuf *O, FILE *f) {
+	obinit(O, f, OBUFSIZE);
+}
+
+
+// writes the buffer to the file
+void obflush(struct obuf *O) {
+	if(O->f != NULL && O->len > 0) {
+		if(fwrite(O->buf, 1, O->len, O->f) != O->len) {
+			fprintf(stderr, "Error writing output.\n");
+			exit(-1);
+		}
+		O->len = 0;
+	}
+}
+
+
+void obclose(struct obuf *O) {
+	obflush(O);
+	free(O->buf);
+}
+
+
+// makes room for n more characters
+void obreserve(struct obuf *O, size_t n) {
+	if(O->len + n <= O->cap) return;
+
+	obflush(O);
+	if(O->len + n > O->cap) {
+		while(O->len + n > O->cap)
+			O->cap *= 2;
+		O->buf = (char *) realloc(O->buf, O->cap);
+		if(O->buf == NULL) {
+			fprintf(stderr, "Memory allocation error in function obreserve.\n");
+			exit(-1);
+		}
+	}
+}
+
+
+void obwrite(struct obuf *O, const char *s, size_t n) {
+	// large blocks go to the file directly
+	if(O->f != NULL && n >= O->cap) {
+		obflush(O);
+		if(fwrite(s, 1, n, O->f) != n) {
+			fprintf(stderr, "Error writing output.\n");
+			exit(-1);
+		}
+		return;
+	}
+
+	obreserve(O, n);
+	memcpy(O->buf + O->len, s, n);
+	O->len += n;
+}
+
+
+void obputs(struct obuf *O, const char *s) {
+	obwrite(O, s, strlen(s));
+}
+
+
+// unsigned integer in decimal, as printf("%llu")
+void obputu(struct obuf *O, unsigned long long x) {
+	char digits[24];
+	int k = sizeof(digits);
+
+	do {
+		digits[--k] = '0' + (char) (x % 10);
+		x /= 10;
+	} while(x > 0);
+
+	obwrite(O, digits + k, sizeof(digits) - k);
+}
+
+
+// 128 bit unsigned integer in decimal, printf cannot print these
+void obputu128(struct obuf *O, unsigned __int128 x) {
+	char digits[40];
+	int k = sizeof(digits);
+
+	do {
+		digits[--k] = '0' + (char) (x % 10);
+		x /= 10;
+	} while(x > 0);
+
+	obwrite(O, digits + k, sizeof(digits) - k);
+}
+
+
+/*
+ * Floating point number with OBPREC decimals, as printf("%17.17Lf"). Since
+ * x = m * 2^e exactly, x * 10^OBPREC is rounded to an integer with 128 bit
+ * arithmetic (to the nearest, ties to even, as glibc does). Doubles are
+ * converted to long double without loss and can be passed as well.
+ */
+void obputfix(struct obuf *O, long double x) {
+	char tmp[64];
+	unsigned long long m;
+	unsigned __int128 q, r, half;
+	long double f;
+	int e, s, k;
+
+	// infinities, NaNs and large values (and long doubles with more than 64
+	// bits of mantissa) are left to printf
+	if(LDBL_MANT_DIG > 64 || !isfinite(x) || fabsl(x) >= 1e19L) {
+		k = snprintf(tmp, sizeof(tmp), "%17.17Lf", x);
+		obwrite(O, tmp, k);
+		return;
+	}
+
+	if(signbit(x)) obwrite(O, "-", 1);
+
+	f = frexpl(fabsl(x), &e);
+	m = (unsigned long long) ldexpl(f, LDBL_MANT_DIG);
+	e -= LDBL_MANT_DIG;
+
+	if(e >= 0) {
+		q = (unsigned __int128) (m << e) * OBSCALE;
+	} else {
+		s = -e;
+		q = (unsigned __int128) m * OBSCALE;
+		if(s >= 128) {
+			// q < 2^121, which is less than half of 2^s
+			q = 0;
+		} else {
+			r = q & ( ((unsigned __int128) 1 << s) - 1 );
+			half = (unsigned __int128) 1 << (s - 1);
+			q >>= s;
+			if(r > half || (r == half && (q & 1))) q++;
+		}
+	}
+
+	obputu128(O, q / OBSCALE);
+
+	// fractional part with leading zeros
+	m = (unsigned long long) (q % OBSCALE);
+	tmp[0] = '.';
+	for(k=OBPREC; k>0; k--) {
+		tmp[k] = '0' + (char) (m % 10);
+		m /= 10;
+	}
+	obwrite(O, tmp, OBPREC + 1);
+}
+
+
+// a block of entries that is formatted by one thread
+struct obblock {
+	struct obuf B;
+	INT start;
+	INT end;
+	void (*item)(struct obuf *, INT, void *);
+	void *ctx;
+};
+
+
+void *obworker(void *arg) {
+	struct obblock *blk = (struct obblock *) arg;
+	INT i;
+
+	for(i=blk->start; i<blk->end; i++)
+		blk->item(&blk->B, i, blk->ctx);
+
+	return NULL;
+}
+
+
+/*
+ * Calls item(B, i, ctx) for i = 0, ..., n-1, which appends the text of
+ * entry i to the buffer B. If the output is long and outthreads > 1, the
+ * entries are formatted in parallel, the text ends up in O in the order of
+ * the entries in any case.
+ */
+void obformat(struct obuf *O, INT n, void (*item)(struct obuf *, INT, void *), void *ctx) {
+	struct obblock *blk;
+	pthread_t *th;
+	INT i, t, num, start;
+
+	num = outthreads;
+	if(num <= 1 || n < 2 * OBITEMS) {
+		for(i=0; i<n; i++)
+			item(O, i, ctx);
+		return;
+	}
+
+	blk = (struct obblock *) calloc(num, sizeof(struct obblock));
+	th = (pthread_t *) calloc(num, sizeof(pthread_t));
+	if(blk == NULL || th == NULL) {
+		fprintf(stderr, "Memory allocation error in function obformat.\n");
+		exit(-1);
+	}
+	for(t=0; t<num; t++) {
+		obinit(&blk[t].B, NULL, OBUFSIZE);
+		blk[t].item = item;
+		blk[t].ctx = ctx;
+	}
+
+	// the memory needed is bounded by processing num * OBITEMS entries at
+	// a time
+	for(start=0; start<n; start += num * OBITEMS) {
+		for(t=0; t<num; t++) {
+			blk[t].B.len = 0;
+			blk[t].start = (start + t * OBITEMS < n) ? start + t * OBITEMS : n;
+			blk[t].end = (blk[t].start + OBITEMS < n) ? blk[t].start + OBITEMS : n;
+			if(pthread_create(&th[t], NULL, &obworker, &blk[t])) {
+				fprintf(stderr, "Error launching thread number %"STR(FINT)"\n", t);
+				exit(-1);
+			}
+		}
+		for(t=0; t<num; t++) {
+			pthread_join(th[t], NULL);
+			obwrite(O, blk[t].B.buf, blk[t].B.len);
+		}
+	}
+
+	for(t=0; t<num; t++)
+		free(blk[t].B.buf);
+	free(blk);
+	free(th);
+}
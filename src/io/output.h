@@ -4,23 +4,37 @@
 
 
 /*
- * Write vertex outdegree profile to file
+ * Write vertex outdegree profile to file, or the array of the numbers of
+ * vertices with outdegree 0, 1, ... to a .npy file
  */
 int outdegprofile(INT *N, INT size, char *outfile) {
 	FILE *outstream;	
+	struct obuf O;
 	INT i, j;
 
 	// open output file if necessary
 	if(outfile == NULL || strlen(outfile) == 0) {
 		outstream = stdout;
 	} else {
-		outstream = fopen(outfile, "a");
+		outstream = openoutput(outfile, "a");
 		if(outstream == NULL) {
 			fprintf(stderr, "Error opening output file %s.\n", outfile);
 			return(-1);
 		}
 	}
 
+	// the profile N[0], ..., N[maximal degree] as an array
+	if(isnpy(outfile)) {
+		for(j=size; j>0 && N[j-1] == 0; j--);
+		obopen(&O, outstream);
+		npyheader(&O, NPYUINT, j);
+		for(i=0; i<j; i++)
+			npyputu(&O, N[i]);
+		obclose(&O);
+		if(outfile != NULL) closestream(outstream);
+		return 0;
+	}
+
 	// output vertex degree profile
 	fprintf(outstream, "{\n");
 	for(i=0; i<size; i++) {
@@ -34,29 +48,40 @@ int outdegprofile(INT *N, INT size, char *outfile) {
 	fprintf(outstream, "\n}\n");
 
 	// close file if necessary
-	if(outfile != NULL) fclose(outstream);
+	if(outfile != NULL) closestream(outstream);
 
 	return 0;
 }
 
 /*
- * Write maximal outdegree to file
+ * Write maximal outdegree to file, as an array with one entry to a .npy file
  */
 int outmdeg(INT *N, INT size, char *outfile) {
 	FILE *outstream;	
+	struct obuf O;
 	INT i;
 
 	// open output file if necessary
 	if(outfile == NULL || strlen(outfile) == 0) {
 		outstream = stdout;
 	} else {
-		outstream = fopen(outfile, "a");
+		outstream = openoutput(outfile, "a");
 		if(outstream == NULL) {
 			fprintf(stderr, "Error opening output file %s.\n", outfile);
 			return(-1);
 		}
 	}
 
+	if(isnpy(outfile)) {
+		for(i=size; i > 1 && N[i-1] == 0; i--);
+		obopen(&O, outstream);
+		npyheader(&O, NPYUINT, 1);
+		npyputu(&O, (i > 0) ? i - 1 : 0);
+		obclose(&O);
+		if(outfile != NULL) closestream(outstream);
+		return 0;
+	}
+
 	// output maximal degree
 	for(i=size; i > 0; i--) {
 		if(N[i-1]>0) {
@@ -66,7 +91,7 @@ int outmdeg(INT *N, INT size, char *outfile) {
 	}
 
 	// close file if necessary
-	if(outfile != NULL) fclose(outstream);
+	if(outfile != NULL) closestream(outstream);
 
 	return 0;
 }
@@ -179,43 +204,212 @@ char *convname(char *outfile, unsigned int counter, unsigned int num, int Tnum)
 }
 
 /*
- * Output graph to graphml format
+ * Turns the output file name *outfile into a container file: the % symbol is
+ * removed, so every sample ends up in the same file. The name belongs to
+ * the container afterwards.
  */
-int outgraph(struct graph *G, char *outfile) {
+void setcontainer(char **outfile) {
+	struct container *c;
+	char *name;
+	size_t i, j;
+
+	if(*outfile == NULL || strlen(*outfile) == 0) return;
+
+	name = (char *) calloc(strlen(*outfile) + 1, sizeof(char));
+	if(name == NULL) {
+		fprintf(stderr, "Memory allocation error in function setcontainer.\n");
+		exit(-1);
+	}
+	for(i=0, j=0; (*outfile)[i] != '\0'; i++) {
+		if((*outfile)[i] != '%') name[j++] = (*outfile)[i];
+	}
+	*outfile = name;
+
+	if(outputcompression(name) != ZNONE) {
+		fprintf(stderr, "Error: container file %s cannot be compressed.\n", name);
+		exit(-1);
+	}
+
+	// several outputs may share a container
+	for(c = containers; c != NULL; c = c->next) {
+		if(strcmp(c->name, name) == 0) {
+			free(name);
+			*outfile = c->name;
+			return;
+		}
+	}
+	newcontainer(name);
+}
+
+
+// the output files of a sample, each of them receives at most one item of
+// the batch of the sample (see writequeue.h)
+const size_t outfiles[] = {
+	offsetof(struct cmdarg, outfile),
+	offsetof(struct cmdarg, loopfile),
+	offsetof(struct cmdarg, loopheightfile),
+	offsetof(struct cmdarg, loopcentfile),
+	offsetof(struct cmdarg, heightfile),
+	offsetof(struct cmdarg, widthfile),
+	offsetof(struct cmdarg, lukafile),
+	offsetof(struct cmdarg, hprocfile),
+	offsetof(struct cmdarg, contourfile),
+	offsetof(struct cmdarg, degfile),
+	offsetof(struct cmdarg, mdegfile),
+	offsetof(struct cmdarg, profile),
+	offsetof(struct cmdarg, centfile),
+	offsetof(struct cmdarg, betweenfile),
+	offsetof(struct cmdarg, eccfile),
+	offsetof(struct cmdarg, diamfile),
+	offsetof(struct cmdarg, distfile),
+	offsetof(struct cmdarg, wienerfile)
+};
+
+#define OUTNUMFILES (sizeof(outfiles) / sizeof(outfiles[0]))
+
+
+// opens the container files of all outputs (--container)
+void setcontainers(struct cmdarg *comarg) {
+	size_t i;
+
+	for(i=0; i<OUTNUMFILES; i++)
+		setcontainer((char **) ((char *) comarg + outfiles[i]));
+}
+
+
+// mode for opening a graph file: the binary formats hold a single graph and
+// are overwritten, graphml files are appended to like all other outputs
+const char *graphmode(char *outfile) {
+	return (hasformat(outfile, ".gbin") || hasformat(outfile, ".bp")) ? "wb" : "a";
+}
+
+
+/*
+ * Output graph to graphml format, or to the binary format if the file name
+ * ends in .gbin, or as balanced parentheses if it ends in .bp (trees only),
+ * each possibly followed by .gz or .zst. The graphml file contains the vertex attributes given by attr (GATTR_*
+ * flags).
+ */
+int outgraphattr(struct graph *G, char *outfile, int attr) {
 	FILE *outstream;	
 
+	if(hasformat(outfile, ".bp")) bpcheck(G);
+
 	// open output file if necessary
 	if(outfile == NULL || strlen(outfile) == 0) {
 		outstream = stdout;
 	} else {
-		outstream = fopen(outfile, "a");
+		outstream = openoutput(outfile, graphmode(outfile));
 		if(outstream == NULL) {
 			fprintf(stderr, "Error opening output file %s.\n", outfile);
 			exit(-1);
 		}
 	}
 
-	print_graphml(G, outstream);
+	if(hasformat(outfile, ".gbin")) {
+		writegbin(G, outstream);
+	} else if(hasformat(outfile, ".bp")) {
+		writebp(G, outstream);
+	} else {
+		print_graphmlattr(G, outstream, attr);
+	}
 	
 	// close file if necessary
-	if(outfile != NULL) fclose(outstream);
+	if(outfile != NULL) closestream(outstream);
 
 	return 0;
 }
 
+int outgraph(struct graph *G, char *outfile) {
+	return outgraphattr(G, outfile, 0);
+}
+
+
+/*
+ * Output the looptree of the tree G in the format chosen by the file name
+ * like outgraph(). The children of a vertex are its neighbours whose height
+ * (height[id], or the height of the vertex if height is NULL) is one larger,
+ * the looptree is written directly from the tree.
+ */
+int outlooptree(struct graph *G, INT *height, char *outfile) {
+	FILE *outstream;
+	struct graph *H;
+	INT i;
+
+	// the looptree is a tree only if G is a path
+	H = NULL;
+	if(hasformat(outfile, ".bp")) {
+		for(i=0; i+1<G->num && ((height != NULL) ? height[i] : G->arr[i]->height) != 0; i++);
+		H = looptree(G, G->arr[i]);
+		bpcheck(H);
+	}
+
+	// open output file if necessary
+	if(outfile == NULL || strlen(outfile) == 0) {
+		outstream = stdout;
+	} else {
+		outstream = openoutput(outfile, graphmode(outfile));
+		if(outstream == NULL) {
+			fprintf(stderr, "Error opening output file %s.\n", outfile);
+			exit(-1);
+		}
+	}
+
+	if(hasformat(outfile, ".gbin")) {
+		writeloopgbin(G, height, outstream);
+	} else if(H != NULL) {
+		writebp(H, outstream);
+		free_graph(H);
+	} else {
+		print_looptree(G, height, outstream);
+	}
+
+	// close file if necessary
+	if(outfile != NULL) closestream(outstream);
+
+	return 0;
+}
+
+
+// entry i of a sequence, preceded by a comma unless it is the first one
+void degitem(struct obuf *B, INT i, void *ctx) {
+	if(i > 0) obputs(B, ", ");
+	obputu(B, ((struct graph *) ctx)->arr[i]->deg);
+}
+
+void heightitem(struct obuf *B, INT i, void *ctx) {
+	if(i > 0) obputs(B, ", ");
+	obputu(B, ((struct graph *) ctx)->arr[i]->height);
+}
+
+void intitem(struct obuf *B, INT i, void *ctx) {
+	if(i > 0) obputs(B, ", ");
+	obputu(B, ((INT *) ctx)[i]);
+}
+
+void intditem(struct obuf *B, INT i, void *ctx) {
+	if(i > 0) obputs(B, ", ");
+	obputu(B, ((INTD *) ctx)[i]);
+}
+
+void doubleitem(struct obuf *B, INT i, void *ctx) {
+	if(i > 0) obputs(B, ", ");
+	obputfix(B, ((DOUBLE *) ctx)[i]);
+}
+
 
 /*
  * Output degree sequence
  */
 int outdegseq(struct graph *G, char *outfile) {
 	FILE *outstream;	
-	INT i;
+	struct obuf O;
 
 	// open output file if necessary
 	if(outfile == NULL || strlen(outfile) == 0) {
 		outstream = stdout;
 	} else {
-		outstream = fopen(outfile, "a");
+		outstream = openoutput(outfile, "a");
 		if(outstream == NULL) {
 			fprintf(stderr, "Error opening output file %s.\n", outfile);
 			exit(-1);
@@ -223,24 +417,29 @@ int outdegseq(struct graph *G, char *outfile) {
 	}
 
 	// output degree sequence
-	fprintf(outstream, "{");
-	for(i=0; i<G->num-1; i++) {
-		fprintf(outstream, "%"STR(FINT)", ", G->arr[i]->deg);	
+	obopen(&O, outstream);
+	if(isnpy(outfile)) {
+		npyheader(&O, NPYUINT, G->num);
+		obformat(&O, G->num, &degbin, G);
+	} else {
+		obputs(&O, "{");
+		obformat(&O, G->num, &degitem, G);
+		obputs(&O, "}\n");
 	}
-	if(G->num>0) fprintf(outstream, "%"STR(FINT), G->arr[G->num - 1]->deg);	
-	fprintf(outstream, "}\n");
+	obclose(&O);
 	
 	// close file if necessary
-	if(outfile != NULL) fclose(outstream);
+	if(outfile != NULL) closestream(outstream);
 
 	return 0;
 }
 
 /*
- * Output maximal degree
+ * Output maximal degree, as an array with one entry to a .npy file
  */
 int outmdeggraph(struct graph *G, char *outfile) {
 	FILE *outstream;	
+	struct obuf O;
 	INT i;
 	INT max;
 
@@ -248,7 +447,7 @@ int outmdeggraph(struct graph *G, char *outfile) {
 	if(outfile == NULL || strlen(outfile) == 0) {
 		outstream = stdout;
 	} else {
-		outstream = fopen(outfile, "a");
+		outstream = openoutput(outfile, "a");
 		if(outstream == NULL) {
 			fprintf(stderr, "Error opening output file %s.\n", outfile);
 			exit(-1);
@@ -259,10 +458,17 @@ int outmdeggraph(struct graph *G, char *outfile) {
 	for(i=0, max=0; i<G->num; i++) {
 		if(G->arr[i]->deg > max) max = G->arr[i]->deg;
 	}
-	fprintf(outstream, "%"STR(FINT)"\n", max);	
+	if(isnpy(outfile)) {
+		obopen(&O, outstream);
+		npyheader(&O, NPYUINT, 1);
+		npyputu(&O, max);
+		obclose(&O);
+	} else {
+		fprintf(outstream, "%"STR(FINT)"\n", max);
+	}
 	
 	// close file if necessary
-	if(outfile != NULL) fclose(outstream);
+	if(outfile != NULL) closestream(outstream);
 
 	return 0;
 }
@@ -273,28 +479,32 @@ int outmdeggraph(struct graph *G, char *outfile) {
  */
 int outheightseq(struct graph *G, char *outfile) {
 	FILE *outstream;	
-	INT i;
+	struct obuf O;
 
 	// open output file if necessary
 	if(outfile == NULL || strlen(outfile) == 0) {
 		outstream = stdout;
 	} else {
-		outstream = fopen(outfile, "a");
+		outstream = openoutput(outfile, "a");
 		if(outstream == NULL) {
 			fprintf(stderr, "Error opening output file %s.\n", outfile);
 			exit(-1);
 		}
 	}
 
-	fprintf(outstream, "{");
-	for(i=0; i<G->num-1; i++) {
-		fprintf(outstream, "%"STR(FINT)", ", G->arr[i]->height);	
+	obopen(&O, outstream);
+	if(isnpy(outfile)) {
+		npyheader(&O, NPYUINT, G->num);
+		obformat(&O, G->num, &heightbin, G);
+	} else {
+		obputs(&O, "{");
+		obformat(&O, G->num, &heightitem, G);
+		obputs(&O, "}\n");
 	}
-	if(G->num>0) fprintf(outstream, "%"STR(FINT), G->arr[G->num - 1]->height);	
-	fprintf(outstream, "}\n");
+	obclose(&O);
 	
 	// close file if necessary
-	if(outfile != NULL) fclose(outstream);
+	if(outfile != NULL) closestream(outstream);
 
 	return 0;
 }
@@ -303,17 +513,20 @@ int outheightseq(struct graph *G, char *outfile) {
 
 
 /*
- * Write a sequence of values to a file or stdout
+ * Write a sequence of values to a file or stdout, as a NumPy array if the
+ * file name ends in .npy
  */
 int outseq(void *seq, INT size, char *outfile, int format) {
 	FILE *outstream;	
-	INT i;
+	struct obuf O;
+	void (*item)(struct obuf *, INT, void *);
+	int npy;
 
 	// open output file if necessary
 	if(outfile == NULL || strlen(outfile) == 0) {
 		outstream = stdout;
 	} else {
-		outstream = fopen(outfile, "a");
+		outstream = openoutput(outfile, "a");
 		if(outstream == NULL) {
 			fprintf(stderr, "Error opening output file %s.\n", outfile);
 			exit(-1);
@@ -322,63 +535,67 @@ int outseq(void *seq, INT size, char *outfile, int format) {
 
 
 	// output values
-	fprintf(outstream, "{");
-	for(i=0; i<size-1; i++) {
-		switch(format) {
-			case 1:
-				// INT
-				fprintf(outstream, "%" STR(FINT) ", ", ((INT *) seq)[i]);
-				break;
-			case 2:
-				// INTD
-				fprintf(outstream, "%" STR(FINTD) ", ", ((INTD *) seq)[i]);
-				break;
-			case 3:
-				// DOUBLE
-				fprintf(outstream, "%" STR(FDOUBLE) ", ", ((DOUBLE *) seq)[i]);
-				break;
-			default:
-				fprintf(stderr, "Error, unknown format in function outseq.\n");
-				exit(-1);
-		}
+	npy = isnpy(outfile);
+	switch(format) {
+		case 1:
+			// INT
+			item = npy ? &intbin : &intitem;
+			break;
+		case 2:
+			// INTD
+			item = npy ? &intdbin : &intditem;
+			break;
+		case 3:
+			// DOUBLE
+			item = npy ? &doublebin : &doubleitem;
+			break;
+		default:
+			fprintf(stderr, "Error, unknown format in function outseq.\n");
+			exit(-1);
 	}
-	if(size>0) {
-		// print last element without comma
-		switch(format) {
-			case 1:
-				// INT
-				fprintf(outstream, "%" STR(FINT), ((INT *) seq)[i]);
-				break;
-			case 2:
-				// INTD
-				fprintf(outstream, "%" STR(FINTD), ((INTD *) seq)[i]);
-				break;
-			case 3:
-				// DOUBLE
-				fprintf(outstream, "%" STR(FDOUBLE), ((DOUBLE *) seq)[i]);
-				break;
-			default:
-				fprintf(stderr, "Error, unknown format in function outseq.\n");
-				exit(-1);
-		}
+	obopen(&O, outstream);
+	if(npy) {
+		npyheader(&O, (format == 3) ? NPYDOUBLE : NPYUINT, size);
+		obformat(&O, size, item, seq);
+	} else {
+		obputs(&O, "{");
+		obformat(&O, size, item, seq);
+		obputs(&O, "}\n");
 	}
-	fprintf(outstream, "}\n");
+	obclose(&O);
 
 	// close file if necessary
-	if(outfile != NULL) fclose(outstream);
+	if(outfile != NULL) closestream(outstream);
 
 	return 0;
 }
 
 
 
-// output closeness centrality 
-int outcent(struct graph *G, char *outfile) {
-	INT i;
-	double num = (double) (G->num-1);
+struct centctx {
+	struct graph *G;
+	INT start;
+	double num;
+};
+
+void centitem(struct obuf *B, INT i, void *ctx) {
+	struct centctx *c = (struct centctx *) ctx;
+
+	if(i > 0) obputs(B, ", ");
+	obputfix(B, c->num / (double) c->G->arr[c->start + i]->cent);
+}
+
+void centbin(struct obuf *B, INT i, void *ctx) {
+	struct centctx *c = (struct centctx *) ctx;
+
+	npyputd(B, c->num / (double) c->G->arr[c->start + i]->cent);
+}
+
+// output closeness centrality of the vertices with ids start, ..., end-1
+int outcent(struct graph *G, char *outfile, INT start, INT end) {
+	struct centctx c;
+	struct obuf O;
 	FILE *outstream;
-	INT start = 0;
-	INT end = G->num;
 
 	//check for sanity of arguments
 	if(start < 0 || end > G->num) {
@@ -389,11 +606,15 @@ int outcent(struct graph *G, char *outfile) {
 		return 0;
 	}
 
+	c.G = G;
+	c.start = start;
+	c.num = (double) (G->num-1);
+
 	// open output file if necessary
 	if(outfile == NULL || strlen(outfile) == 0) {
 		outstream = stdout;
 	} else {
-		outstream = fopen(outfile, "a");
+		outstream = openoutput(outfile, "a");
 		if(outstream == NULL) {
 			fprintf(stderr, "Error opening output file.\n");
 			exit(-1);
@@ -401,17 +622,134 @@ int outcent(struct graph *G, char *outfile) {
 	}
 
 	// output closeness centrality of vertices
-	fprintf(outstream, "{");
-	for(i=start; i<end-1; i++) {
-		fprintf(outstream, "%17.17f, ", num / (double) G->arr[i]->cent);	
+	obopen(&O, outstream);
+	if(isnpy(outfile)) {
+		npyheader(&O, NPYDOUBLE, end - start);
+		obformat(&O, end - start, &centbin, &c);
+	} else {
+		obputs(&O, "{");
+		obformat(&O, end - start, &centitem, &c);
+		obputs(&O, "}\n");
+	}
+	obclose(&O);
+
+	// close file if necessary
+	if(outfile != NULL) closestream(outstream);	
+
+	return 0;
+}
+
+
+/*
+ * Output diameter, radius and the id of a center vertex
+ */
+int outdiameter(struct diam *res, char *outfile) {
+	INT seq[3];
+
+	seq[0] = res->diameter;
+	seq[1] = res->radius;
+	seq[2] = res->center->id;
+
+	return outseq(seq, 3, outfile, 1);
+}
+
+
+/*
+ * Output the distance distribution {h(1), h(2), ..., h(D)}, where h(d) is
+ * the number of unordered pairs of vertices at distance d and D is the
+ * largest distance. The array hist has num entries.
+ */
+int outdistances(INTD *hist, INT num, char *outfile) {
+	INT D;
+
+	for(D = num; D > 1 && hist[D-1] == 0; D--);
+
+	return outseq(hist + 1, (D > 0) ? D - 1 : 0, outfile, 2);
+}
+
+
+/*
+ * Output the height, the width and the width profile as a list
+ * {height, width, {W[0], W[1], ..., W[height]}}, where W[h] is the number of
+ * vertices at height h and the width is the largest W[h]. The array W has
+ * num = height + 1 entries. As a NumPy array only the profile is written.
+ */
+int outwidth(INT *W, INT num, char *outfile) {
+	FILE *outstream;
+	struct obuf O;
+	INT i, width;
+
+	if(isnpy(outfile)) return outseq(W, num, outfile, 1);
+
+	for(i=0, width=0; i<num; i++)
+		if(W[i] > width) width = W[i];
+
+	// open output file if necessary
+	if(outfile == NULL || strlen(outfile) == 0) {
+		outstream = stdout;
+	} else {
+		outstream = openoutput(outfile, "a");
+		if(outstream == NULL) {
+			fprintf(stderr, "Error opening output file %s.\n", outfile);
+			exit(-1);
+		}
 	}
-	if(end>0) fprintf(outstream, "%17.17f", num / (double) G->arr[end-1]->cent);	
-	fprintf(outstream, "}\n");
+
+	obopen(&O, outstream);
+	obputs(&O, "{");
+	obputu(&O, (num > 0) ? num - 1 : 0);
+	obputs(&O, ", ");
+	obputu(&O, width);
+	obputs(&O, ", {");
+	obformat(&O, num, &intitem, W);
+	obputs(&O, "}}\n");
+	obclose(&O);
 
 	// close file if necessary
-	if(outfile != NULL) fclose(outstream);	
+	if(outfile != NULL) closestream(outstream);
 
 	return 0;
 }
 
 
+/*
+ * Output the Wiener index w (the sum of the distances of all unordered pairs
+ * of vertices) and the average distance as a list {wiener, average}, to a
+ * .npy file as an array of two doubles
+ */
+int outwiener(INTW w, INT num, char *outfile) {
+	FILE *outstream;
+	struct obuf O;
+	DOUBLE avg, seq[2];
+
+	avg = (num > 1) ? (DOUBLE) w / ( (DOUBLE) num * (DOUBLE) (num - 1) / 2.0 ) : 0.0;
+	if(isnpy(outfile)) {
+		seq[0] = (DOUBLE) w;
+		seq[1] = avg;
+		return outseq(seq, 2, outfile, 3);
+	}
+
+	// open output file if necessary
+	if(outfile == NULL || strlen(outfile) == 0) {
+		outstream = stdout;
+	} else {
+		outstream = openoutput(outfile, "a");
+		if(outstream == NULL) {
+			fprintf(stderr, "Error opening output file %s.\n", outfile);
+			exit(-1);
+		}
+	}
+
+	obopen(&O, outstream);
+	obputs(&O, "{");
+	obputu128(&O, w);
+	obputs(&O, ", ");
+	obputfix(&O, avg);
+	obputs(&O, "}\n");
+	obclose(&O);
+
+	// close file if necessary
+	if(outfile != NULL) closestream(outstream);
+
+	return 0;
+}
@@ -0,0 +1,223 @@
+/*
+ * Decimated Lukasiewicz path, height process and contour process of trees
+ *
+ * For plots of scaling limits only the shape of these paths matters, but a
+ * tree with n vertices has n+1, n and 2n-1 points in them. The points of a
+ * path are therefore fed one after the other into at most res buckets of
+ * consecutive points, and only the smallest and the largest value of every
+ * bucket are kept, together with the time of its first point rescaled to
+ * [0, 1]. The extreme values of the path survive the decimation, and the
+ * memory and the output size only depend on res.
+ *
+ * The Lukasiewicz path S(0) = 0, S(k+1) = S(k) + D(k) - 1 is taken along the
+ * outdegrees D in breadth-first-search order, the order in which the trees
+ * are generated; for Galton-Watson trees it has the same law as the path in
+ * depth-first-search order. The height process is the sequence of heights
+ * in depth-first-search order and the contour process follows the heights
+ * along a walk around the tree that traverses every edge twice. The heights
+ * are taken from an array indexed by the vertex ids, or from the vertices if
+ * it is NULL.
+ *
+ * Usage:
+ *		P = newpath(len, res);
+ *		pathpoint(P, x);			// len times
+ *		outpath(P, outfile);		// also frees P
+ */
+
+
+struct path {
+	INT len;			// number of points of the path
+	INT num;			// number of buckets
+	INT pos;			// number of points so far
+	INT b;				// number of started buckets
+	INT end;			// first point after the last started bucket
+	long long *min;
+	long long *max;
+};
+
+
+struct path *newpath(INT len, INT res) {
+	struct path *P;
+
+	P = (struct path *) calloc(1, sizeof(struct path));
+	if(P == NULL) {
+		fprintf(stderr, "Memory allocation error in function newpath.\n");
+		exit(-1);
+	}
+	P->len = len;
+	P->num = (len < res) ? len : res;
+	P->min = (long long *) malloc((P->num + 1) * sizeof(long long));
+	P->max = (long long *) malloc((P->num + 1) * sizeof(long long));
+	if(P->min == NULL || P->max == NULL) {
+		fprintf(stderr, "Memory allocation error in function newpath.\n");
+		exit(-1);
+	}
+
+	return P;
+}
+
+
+void freepath(struct path *P) {
+	free(P->min);
+	free(P->max);
+	free(P);
+}
+
+
+// first point of bucket k
+INT pathstart(struct path *P, INT k) {
+	return (INT) (((INTD) k * P->len) / P->num);
+}
+
+
+// adds the next point x of the path
+void pathpoint(struct path *P, long long x) {
+	INT k;
+
+	if(P->pos == P->end) {
+		// first point of the next bucket
+		k = P->b++;
+		P->end = pathstart(P, k + 1);
+		P->min[k] = x;
+		P->max[k] = x;
+	} else {
+		k = P->b - 1;
+		if(x < P->min[k]) P->min[k] = x;
+		if(x > P->max[k]) P->max[k] = x;
+	}
+	P->pos++;
+}
+
+
+// Lukasiewicz path of the outdegrees D[0], ..., D[len-1]
+struct path *lukapath(INT *D, INT len, INT res) {
+	struct path *P;
+	long long s;
+	INT i;
+
+	P = newpath(len + 1, res);
+	pathpoint(P, 0);
+	for(i=0, s=0; i<len; i++) {
+		s += (long long) D[i] - 1;
+		pathpoint(P, s);
+	}
+
+	return P;
+}
+
+
+// Lukasiewicz path of a tree with the vertices bfs[0], ..., bfs[len-1] in
+// bfs order, the children of a vertex are the neighbours one level below
+struct path *treelukapath(struct vertex **bfs, INT *height, INT len, INT res) {
+	struct path *P;
+	struct list *li;
+	long long s;
+	INT i, h;
+
+	P = newpath(len + 1, res);
+	pathpoint(P, 0);
+	for(i=0, s=0; i<len; i++) {
+		h = (height != NULL) ? height[bfs[i]->id] : bfs[i]->height;
+		for(li = bfs[i]->qu->li; li != NULL; li = li->ne)
+			if(((height != NULL) ? height[li->ve->id] : li->ve->height) == h + 1) s++;
+		pathpoint(P, --s);
+	}
+
+	return P;
+}
+
+
+// height process of the vertices dfs[0], ..., dfs[len-1] in dfs order
+struct path *heightpath(struct vertex **dfs, INT *height, INT len, INT res) {
+	struct path *P;
+	INT i;
+
+	P = newpath(len, res);
+	for(i=0; i<len; i++)
+		pathpoint(P, (height != NULL) ? height[dfs[i]->id] : dfs[i]->height);
+
+	return P;
+}
+
+
+// contour process of the tree with the vertices dfs[0], ..., dfs[len-1]
+struct path *contourpath(struct vertex **dfs, INT *height, INT len, INT res) {
+	struct path *P;
+	long long h, next;
+	INT i;
+
+	P = newpath((len > 0) ? 2 * len - 1 : 0, res);
+	if(len == 0) return P;
+
+	// the walk climbs down from a vertex to the parent of the next one and
+	// up to the next one, after the last vertex back to the root
+	h = 0;
+	pathpoint(P, h);
+	for(i=1; i<len; i++) {
+		next = (height != NULL) ? height[dfs[i]->id] : dfs[i]->height;
+		while(h >= next)
+			pathpoint(P, --h);
+		pathpoint(P, ++h);
+	}
+	while(h > 0)
+		pathpoint(P, --h);
+
+	return P;
+}
+
+
+/*
+ * Writes the buckets as a list {{t, min, max}, ...}, where t in [0, 1] is the
+ * rescaled time of the first point of a bucket. As a NumPy array every
+ * bucket is a row of three doubles. Frees P.
+ */
+int outpath(struct path *P, char *outfile) {
+	FILE *outstream;
+	struct obuf O;
+	DOUBLE t;
+	INT k;
+
+	// open output file if necessary
+	if(outfile == NULL || strlen(outfile) == 0) {
+		outstream = stdout;
+	} else {
+		outstream = openoutput(outfile, "a");
+		if(outstream == NULL) {
+			fprintf(stderr, "Error opening output file %s.\n", outfile);
+			exit(-1);
+		}
+	}
+
+	obopen(&O, outstream);
+	if(isnpy(outfile)) {
+		// a two-dimensional array with one row per bucket
+		npymatrix(&O, NPYDOUBLE, P->b, 3);
+		for(k=0; k<P->b; k++) {
+			t = (P->len > 1) ? (DOUBLE) pathstart(P, k) / (DOUBLE) (P->len - 1) : 0.0;
+			npyputd(&O, (double) t);
+			npyputd(&O, (double) P->min[k]);
+			npyputd(&O, (double) P->max[k]);
+		}
+	} else {
+		obputs(&O, "{");
+		for(k=0; k<P->b; k++) {
+			t = (P->len > 1) ? (DOUBLE) pathstart(P, k) / (DOUBLE) (P->len - 1) : 0.0;
+			obputs(&O, (k > 0) ? ", {" : "{");
+			obputfix(&O, t);
+			obputs(&O, (P->min[k] < 0) ? ", -" : ", ");
+			obputu(&O, (P->min[k] < 0) ? -P->min[k] : P->min[k]);
+			obputs(&O, (P->max[k] < 0) ? ", -" : ", ");
+			obputu(&O, (P->max[k] < 0) ? -P->max[k] : P->max[k]);
+			obputs(&O, "}");
+		}
+		obputs(&O, "}\n");
+	}
+	obclose(&O);
+
+	// close file if necessary
+	if(outfile != NULL) closestream(outstream);
+
+	freepath(P);
+
+	return 0;
+}
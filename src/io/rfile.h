@@ -1,80 +1,813 @@
 
 /*
- * Read connected graph from file instead of generating the graph at random
+ * Reads the graph in infile, the format is chosen by the name of the file or
+ * its first bytes. The vertices of the roots given by --vertex are stored in
+ * roots, which may be NULL if there is at most one root.
  */
-int rfile(struct cmdarg *comarg) {
-	struct graph *G, *H;
+struct graph *readgraph(struct cmdarg *comarg, char *infile, struct vertex **roots, INT numThreads) {
+	struct graph *G;
+	struct roots R, *P;
+	struct vertex *first;
+
+	R.id = comarg->rootid;
+	R.num = comarg->numroots;
+	R.v = (roots != NULL) ? roots : &first;
+	P = (R.num > 0) ? &R : NULL;
+
+	G = readgbin(infile, P);
+	if(G == NULL) G = readbp(infile, P);
+	if(G == NULL) G = readtextgraph(infile, P, numThreads);
+	if(G == NULL) G = parsegraphml(infile, P, numThreads);
+
+	return G;
+}
+
+
+/*
+ * Splits G into its connected components, returns an array with G itself if
+ * G is connected. G is freed otherwise.
+ */
+struct graph **graphcomponents(struct cmdarg *comarg, struct graph *G, INT numThreads, INT *numcomp) {
+	struct graph **C;
+	INT *comp;
+
+	*numcomp = 1;
+	comp = (G->num > 1) ? components(G, numThreads, numcomp) : NULL;
+
+	if(*numcomp == 1) {
+		C = (struct graph **) malloc(sizeof(struct graph *));
+		if(C == NULL) {
+			fprintf(stderr, "Memory allocation error in function graphcomponents.\n");
+			exit(-1);
+		}
+		C[0] = G;
+	} else {
+		if(comarg->Tcentrange || comarg->Tckptfile) {
+			fprintf(stderr, "Error: --cent-range and --checkpoint require a connected graph.\n");
+			exit(-1);
+		}
+		if(comarg->numroots > 1) {
+			fprintf(stderr, "Error: several root vertices require a connected graph.\n");
+			exit(-1);
+		}
+		C = splitgraph(G, comp, *numcomp);
+		free_graph(G);
+	}
+
+	if(comp != NULL) free(comp);
+
+	return C;
+}
+
+
+/*
+ * Calculates the requested statistics of the connected graph G using
+ * numThreads threads. Returns the outputs as a batch, which frees G after
+ * writing, the % symbol of the output file names is replaced by counter.
+ */
+struct outbatch *analysegraph(struct cmdarg *comarg, struct graph *G, INT numThreads, unsigned int counter) {
+	struct outbatch *B;
+	struct outitem *it;
 	INT *degprofile;
+	INT *ord;
+	INT *ecc;
+	INT *par;
+	INT *lhei;
+	INT *wid;
+	INT *dist;
+	struct path *P;
+	DOUBLE *btw;
+	DOUBLE *lclo;
+	struct diam dm;
+	struct vertex **src, **dfs, **queue;
+	INTD *hist;
+	INTW wiener;
+	INT centend, numh, i;
+	char *cname;
 
 
-	/* read graph from file */
-	G = parsegraphml(comarg->infile, comarg->vid);
+	// the outputs are written after the calculations, the batch frees the
+	// graph afterwards
+	B = newbatch(NULL);
+	batchgraph(B, G);
 
-	if(G->num == 0) return 0;	 // nothing to do if there are no vertices
+	if(G->num == 0) return B;	 // nothing to do if there are no vertices
 
 	if(G->root == NULL) G->root = G->arr[0]; // set root if none was specified
 
+	/* range of vertices for the closeness centrality */
+	centend = (comarg->centend == 0) ? G->num : comarg->centend;
+	if(centend > G->num || comarg->centstart >= centend) {
+		fprintf(stderr, "Error: --cent-range exceeds the number of vertices.\n");
+		exit(-1);
+	}
+
+	/* renumber vertices for the traversals if requested */
+	ord = reordergraph(G, G->root, comarg->reorder);
+
 	/* set height, vertex degrees, bfs order, disconnected warning flag */
-	G->bfs = bfsorder(G, G->root, 1, 1);
+	// heights read from the input file are kept unless another root was
+	// specified
+	G->bfs = parbfsorder(G, G->root, 1, !((G->attr & GATTR_HEIGHT) && (G->attr & GATTR_PARENT) && comarg->vid == NULL), numThreads);
 	if(G->disconnected) {
-		fprintf(stderr, "Error: graph from input file is disconnected. Disconnected graphs are not supported at the moment.\n"); 
+		fprintf(stderr, "Error: graph from input file is not connected along its directed edges. Such graphs are not supported at the moment.\n");
 		exit(-1);
 	}
 
+	/* trees have linear time algorithms for most statistics */
+	par = treecheck(G, G->root);
+	if( (comarg->Tloopfile || comarg->Tloopheightfile || comarg->Tloopcentfile) && par == NULL ) {
+		fprintf(stderr, "Error: graph from input file is not a tree. Cannot construct loop tree.\n");
+		exit(-1);
+	}
+	if( (comarg->Tlukafile || comarg->Thprocfile || comarg->Tcontourfile) && par == NULL ) {
+		fprintf(stderr, "Error: graph from input file is not a tree. Cannot compute its Lukasiewicz path, height or contour process.\n");
+		exit(-1);
+	}
+
+	/* Calculate closeness centrality, eccentricities and distance
+	 * distribution if requested */
+	/* for graphs all of them need a breadth-first search from every vertex */
+	ecc = NULL;
+	hist = NULL;
+	if( (G->attr & GATTR_CENT) && !comarg->Teccfile && !comarg->Tdistfile ) {
+		// the sums of the distances were read from the input file (written
+		// with --attributes), closeness and Wiener index follow from them
+	} else if( par != NULL ) {
+		// the whole list is cheaper than a range or a checkpoint
+		if( comarg->Tcentfile || comarg->Twienerfile )
+			treecloseness(G, G->bfs, par);
+		if( comarg->Teccfile )
+			ecc = treeeccentricity(G, G->root);
+		if( comarg->Tdistfile )
+			hist = treedistances(G);
+	} else if( comarg->Tcentfile && !comarg->Teccfile && !comarg->Tdistfile && !comarg->Twienerfile && (comarg->Tcentrange || comarg->Tckptfile) ) {
+		// only a range of vertices, possibly resuming from a checkpoint
+		src = origorder(G, ord);
+		rangedcentrality(G, src, comarg->centstart, centend, numThreads, comarg->ckptfile);
+		free(src);
+	} else if( comarg->Tcentfile || comarg->Teccfile || comarg->Tdistfile || comarg->Twienerfile ) {
+		if( comarg->Teccfile ) {
+			ecc = (INT *) calloc(G->num, sizeof(INT));
+			if(ecc == NULL) {
+				fprintf(stderr, "Memory allocation error in function rfile.\n");
+				exit(-1);
+			}
+		}
+		if( comarg->Tdistfile ) {
+			hist = (INTD *) calloc(G->num, sizeof(INTD));
+			if(hist == NULL) {
+				fprintf(stderr, "Memory allocation error in function rfile.\n");
+				exit(-1);
+			}
+		}
+		threadedcentrality(G, 0, G->num, numThreads, ecc, hist);
+
+		// the searches count every unordered pair twice
+		if( comarg->Tdistfile ) {
+			for(i=1; i<G->num; i++)
+				hist[i] /= 2;
+		}
+	}
+	wiener = 0;
+	if( comarg->Twienerfile ) {
+		for(i=0; i<G->num; i++)
+			wiener += G->arr[i]->cent;
+		wiener /= 2;
+	}
+
+	/* Calculate betweenness centrality if requested */
+	btw = NULL;
+	if( comarg->Tbetweenfile ) {
+		btw = (par != NULL) ? treebetweenness(G, G->bfs) : threadedbetweenness(G, numThreads);
+	}
+
+	/* Calculate diameter, radius and center if requested */
+	if( comarg->Tdiamfile ) {
+		if(par != NULL) treediameter(G, G->root, &dm);
+		else graphdiameter(G, G->root, numThreads, &dm);
+	}
+
+	/* Calculate heights and closeness centrality in the looptree if
+	 * requested */
+	lhei = (comarg->Tloopheightfile) ? loopheights(G, G->bfs, par) : NULL;
+	lclo = (comarg->Tloopcentfile) ? loopcloseness(G, G->bfs, par) : NULL;
+
+	/* restore original vertex ids before writing any output */
+	unpermute(ecc, sizeof(INT), G->num, ord);
+	unpermute(btw, sizeof(DOUBLE), G->num, ord);
+	unpermute(lhei, sizeof(INT), G->num, ord);
+	unpermute(lclo, sizeof(DOUBLE), G->num, ord);
+	undoreorder(G, ord);
+
 	/* output degree sequence if requested */
 	if( comarg->Tdegfile ) {
-		outdegseq(G, comarg->degfile);
+		cname = convname(comarg->degfile, counter, comarg->num, comarg->Tnum);
+		additem(B, OUT_DEGSEQ, cname, G, NULL, 0, 0, 0);
 	}
 	
 	/* output maximal degree if requested */
 	if( comarg->Tmdegfile ) {
-		outmdeggraph(G, comarg->mdegfile);
+		cname = convname(comarg->mdegfile, counter, comarg->num, comarg->Tnum);
+		additem(B, OUT_MDEGGRAPH, cname, G, NULL, 0, 0, 0);
 	}
 
 	/* output degree profile if requested */
 	if( comarg->Tprofile ) {
 		degprofile = makedegprofile(G);	// assumes that the deg parameters
 										// have already been set
-		outdegprofile(degprofile, G->num, comarg->profile);
-		free(degprofile);
+		B->degprofile = degprofile;
+		cname = convname(comarg->profile, counter, comarg->num, comarg->Tnum);
+		additem(B, OUT_PROFILE, cname, NULL, degprofile, G->num, 0, G->num * sizeof(INT));
 	}
 	
 	/* output height sequence if requested */
 	if( comarg->Theightfile ) {
-		outheightseq(G, comarg->heightfile);
+		cname = convname(comarg->heightfile, counter, comarg->num, comarg->Tnum);
+		additem(B, OUT_HEIGHTSEQ, cname, G, NULL, 0, 0, 0);
+	}
+
+	/* output width profile if requested */
+	if( comarg->Twidthfile ) {
+		cname = convname(comarg->widthfile, counter, comarg->num, comarg->Tnum);
+		wid = makewidthprofile(G, NULL, &numh);
+		additem(B, OUT_WIDTH, cname, NULL, wid, numh, 0, numh * sizeof(INT));
 	}
 
-	/* Calculate closeness centrality if requested */
+	/* output decimated Lukasiewicz path, height and contour process if
+	 * requested */
+	if( comarg->Tlukafile ) {
+		cname = convname(comarg->lukafile, counter, comarg->num, comarg->Tnum);
+		// the order of G->bfs within a level depends on the number of
+		// threads, the sequential search follows the neighbourhood lists
+		// like treedfsorder()
+		dist = (INT *) malloc(G->num * sizeof(INT));
+		queue = (struct vertex **) malloc(G->num * sizeof(struct vertex *));
+		if(dist == NULL || queue == NULL) {
+			fprintf(stderr, "Memory allocation error in function analysegraph.\n");
+			exit(-1);
+		}
+		bfsdist(G, G->root, dist, queue);
+		P = treelukapath(queue, dist, G->num, comarg->resolution);
+		free(dist);
+		free(queue);
+		additem(B, OUT_PATH, cname, NULL, P, 0, 0, 2 * P->num * sizeof(long long));
+	}
+	if( comarg->Thprocfile || comarg->Tcontourfile ) {
+		dfs = treedfsorder(G, G->root, NULL);
+		if( comarg->Thprocfile ) {
+			cname = convname(comarg->hprocfile, counter, comarg->num, comarg->Tnum);
+			P = heightpath(dfs, NULL, G->num, comarg->resolution);
+			additem(B, OUT_PATH, cname, NULL, P, 0, 0, 2 * P->num * sizeof(long long));
+		}
+		if( comarg->Tcontourfile ) {
+			cname = convname(comarg->contourfile, counter, comarg->num, comarg->Tnum);
+			P = contourpath(dfs, NULL, G->num, comarg->resolution);
+			additem(B, OUT_PATH, cname, NULL, P, 0, 0, 2 * P->num * sizeof(long long));
+		}
+		free(dfs);
+	}
+
+	/* output closeness centrality if requested */
 	if( comarg->Tcentfile ) {
-		threadedcentrality(G, 0, G->num, comarg->threads);
-		outcent(G, comarg->centfile);
+		cname = convname(comarg->centfile, counter, comarg->num, comarg->Tnum);
+		it = additem(B, OUT_CENT, cname, G, NULL, centend, 0, 0);
+		it->first = comarg->centstart;
+	}
+
+	/* output betweenness centrality if requested */
+	if( comarg->Tbetweenfile ) {
+		cname = convname(comarg->betweenfile, counter, comarg->num, comarg->Tnum);
+		additem(B, OUT_SEQ, cname, NULL, btw, G->num, 3, G->num * sizeof(DOUBLE));
+	}
+
+	/* output eccentricities if requested */
+	if( comarg->Teccfile ) {
+		cname = convname(comarg->eccfile, counter, comarg->num, comarg->Tnum);
+		additem(B, OUT_SEQ, cname, NULL, ecc, G->num, 1, G->num * sizeof(INT));
+	}
+
+	/* output diameter, radius and center if requested */
+	if( comarg->Tdiamfile ) {
+		cname = convname(comarg->diamfile, counter, comarg->num, comarg->Tnum);
+		it = additem(B, OUT_DIAMETER, cname, NULL, NULL, 0, 0, 0);
+		it->dm = dm;
+	}
+
+	/* output distance distribution if requested */
+	if( comarg->Tdistfile ) {
+		cname = convname(comarg->distfile, counter, comarg->num, comarg->Tnum);
+		additem(B, OUT_DISTANCES, cname, NULL, hist, G->num, 0, G->num * sizeof(INTD));
+	}
+
+	/* output Wiener index and average distance if requested */
+	if( comarg->Twienerfile ) {
+		cname = convname(comarg->wienerfile, counter, comarg->num, comarg->Tnum);
+		it = additem(B, OUT_WIENER, cname, NULL, NULL, G->num, 0, 0);
+		it->wiener = wiener;
 	}
 
-	/* calculate and output looptree if requested */	
-	/* this only works if the graph is a tree */
+	/* output looptree if requested */
+	/* this only works if the graph is a tree, it is written directly from
+	 * the tree with the heights from the root */
 	if( comarg->Tloopfile ) {
-		/*
-		// check if the graph is a tree (works only in case of undirected edges)
-		for(sum=0, i=0; i<G->num; i++){
-			sum += G->arr[i]->deg
-		}
-		// sum_v d(v) = 2 * #edges = 2 * (#vertices -1)
-		if(sum + 2 != 2*G->num) {	
-			fprintf(stderr, "Error: Graph is not a tree. Cannot construct loop tree.\n");
+		cname = convname(comarg->loopfile, counter, comarg->num, comarg->Tnum);
+		additem(B, OUT_LOOPTREE, cname, G, NULL, 0, 0, 0);
+	}
+
+	/* output heights in the looptree if requested */
+	if( comarg->Tloopheightfile ) {
+		cname = convname(comarg->loopheightfile, counter, comarg->num, comarg->Tnum);
+		additem(B, OUT_SEQ, cname, NULL, lhei, G->num, 1, G->num * sizeof(INT));
+	}
+
+	/* output closeness centrality in the looptree if requested */
+	if( comarg->Tloopcentfile ) {
+		cname = convname(comarg->loopcentfile, counter, comarg->num, comarg->Tnum);
+		additem(B, OUT_SEQ, cname, NULL, lclo, G->num, 3, G->num * sizeof(DOUBLE));
+	}
+
+	if(par != NULL) free(par);
+
+	return B;
+}
+
+
+/*
+ * Calculates the outputs of G that depend on the root, the heights, the width
+ * profile, the decimated paths and the looptree with its heights and
+ * closeness centrality, for another root of G.
+ * The graph is only read, so several roots can be analysed at the same
+ * time. The batch does not free G.
+ */
+struct outbatch *analyseroot(struct cmdarg *comarg, struct graph *G, struct vertex *root, unsigned int counter) {
+	struct outbatch *B;
+	struct vertex **queue, **dfs;
+	struct list *li;
+	struct path *P;
+	INT *dist, *par, *lhei, *wid;
+	DOUBLE *lclo;
+	INT i, numh;
+	char *cname;
+
+	B = newbatch(NULL);
+	if( !comarg->Theightfile && !comarg->Twidthfile && !comarg->Tlukafile && !comarg->Thprocfile && !comarg->Tcontourfile && !comarg->Tloopfile && !comarg->Tloopheightfile && !comarg->Tloopcentfile ) return B;
+
+	/* heights from this root */
+	dist = (INT *) malloc(G->num * sizeof(INT));
+	queue = (struct vertex **) malloc(G->num * sizeof(struct vertex *));
+	if(dist == NULL || queue == NULL) {
+		fprintf(stderr, "Memory allocation error in function analyseroot.\n");
+		exit(-1);
+	}
+	if(bfsdist(G, root, dist, queue) < G->num) {
+		fprintf(stderr, "Error: graph from input file is not connected along its directed edges. Such graphs are not supported at the moment.\n");
+		exit(-1);
+	}
+
+	/* heights and closeness centrality in the looptree if requested */
+	// the parent of a vertex is the neighbour one level closer to the root,
+	// the queue holds the bfs order
+	if( comarg->Tloopheightfile || comarg->Tloopcentfile ) {
+		par = (INT *) malloc(G->num * sizeof(INT));
+		if(par == NULL) {
+			fprintf(stderr, "Memory allocation error in function analyseroot.\n");
+			exit(-1);
+		}
+		for(i=0; i<G->num; i++) {
+			par[i] = G->num;
+			for(li = G->arr[i]->qu->li; li != NULL && dist[li->ve->id] + 1 != dist[i]; li = li->ne);
+			if(li != NULL) par[i] = li->ve->id;
+		}
+		if( comarg->Tloopheightfile ) {
+			cname = convname(comarg->loopheightfile, counter, comarg->num, comarg->Tnum);
+			lhei = loopheights(G, queue, par);
+			additem(B, OUT_SEQ, cname, NULL, lhei, G->num, 1, G->num * sizeof(INT));
+		}
+		if( comarg->Tloopcentfile ) {
+			cname = convname(comarg->loopcentfile, counter, comarg->num, comarg->Tnum);
+			lclo = loopcloseness(G, queue, par);
+			additem(B, OUT_SEQ, cname, NULL, lclo, G->num, 3, G->num * sizeof(DOUBLE));
+		}
+		free(par);
+	}
+
+	/* decimated Lukasiewicz path, height and contour process if requested */
+	// analysegraph() has checked that G is a tree
+	if( comarg->Tlukafile ) {
+		cname = convname(comarg->lukafile, counter, comarg->num, comarg->Tnum);
+		P = treelukapath(queue, dist, G->num, comarg->resolution);
+		additem(B, OUT_PATH, cname, NULL, P, 0, 0, 2 * P->num * sizeof(long long));
+	}
+	if( comarg->Thprocfile || comarg->Tcontourfile ) {
+		dfs = treedfsorder(G, root, dist);
+		if( comarg->Thprocfile ) {
+			cname = convname(comarg->hprocfile, counter, comarg->num, comarg->Tnum);
+			P = heightpath(dfs, dist, G->num, comarg->resolution);
+			additem(B, OUT_PATH, cname, NULL, P, 0, 0, 2 * P->num * sizeof(long long));
+		}
+		if( comarg->Tcontourfile ) {
+			cname = convname(comarg->contourfile, counter, comarg->num, comarg->Tnum);
+			P = contourpath(dfs, dist, G->num, comarg->resolution);
+			additem(B, OUT_PATH, cname, NULL, P, 0, 0, 2 * P->num * sizeof(long long));
+		}
+		free(dfs);
+	}
+	free(queue);
+
+	/* output width profile if requested */
+	if( comarg->Twidthfile ) {
+		cname = convname(comarg->widthfile, counter, comarg->num, comarg->Tnum);
+		wid = makewidthprofile(G, dist, &numh);
+		additem(B, OUT_WIDTH, cname, NULL, wid, numh, 0, numh * sizeof(INT));
+	}
+
+	/* output looptree if requested */
+	// analysegraph() has checked that G is a tree, the looptree is written
+	// first since the height sequence frees the heights
+	if( comarg->Tloopfile ) {
+		cname = convname(comarg->loopfile, counter, comarg->num, comarg->Tnum);
+		additem(B, OUT_LOOPTREE, cname, G, dist, 0, !comarg->Theightfile, comarg->Theightfile ? 0 : G->num * sizeof(INT));
+	}
+
+	/* output height sequence if requested */
+	if( comarg->Theightfile ) {
+		cname = convname(comarg->heightfile, counter, comarg->num, comarg->Tnum);
+		additem(B, OUT_SEQ, cname, NULL, dist, G->num, 1, G->num * sizeof(INT));
+	}
+	if( !comarg->Theightfile && !comarg->Tloopfile ) free(dist);
+
+	return B;
+}
+
+
+/*
+ * Reads the graph in infile and analyses its components one after the
+ * other. Returns the batches of the components, linked by their next fields.
+ */
+struct outbatch *analysefile(struct cmdarg *comarg, char *infile, INT numThreads, unsigned int counter) {
+	struct graph **C;
+	struct outbatch *B, *first, *last;
+	INT numcomp, k;
+
+	C = graphcomponents(comarg, readgraph(comarg, infile, NULL, numThreads), numThreads, &numcomp);
+
+	first = NULL;
+	last = NULL;
+	for(k=0; k<numcomp; k++) {
+		B = analysegraph(comarg, C[k], numThreads, counter);
+		B->next = NULL;
+		if(last != NULL) last->next = B;
+		else first = B;
+		last = B;
+	}
+	free(C);
+
+	return first;
+}
+
+
+/*
+ * Pool of threads that analyses files, the components of a graph or the
+ * roots of a graph. Each file, component or root is analysed by one thread
+ * (or a few if there are more threads than files), the components that hold
+ * a large part of the vertices and the first root are analysed with all
+ * threads beforehand. The finished batches are handed to the writer in the
+ * order of the files, components or roots, so aggregated output files look
+ * as if they had been analysed one after the other.
+ */
+struct filepool {
+	struct cmdarg *comarg;
+	char **files;
+	struct graph **graphs;		// components, if files is NULL
+	struct vertex **roots;		// roots of graphs[0], if not NULL
+	INT num;
+	INT inner;					// threads per file
+	INT next;					// next file to analyse
+	INT written;				// next file to hand to the writer
+	INT window;					// files that may be ahead of the writer
+	struct outbatch **done;		// finished batches waiting for the writer
+	struct outqueue Q;
+	pthread_mutex_t mut;
+	pthread_cond_t progress;	// written has increased
+	INT ticket;					// next ticket for handing over batches
+	INT serving;				// ticket whose batches go to the writer now
+	pthread_mutex_t handmut;	// protects serving
+	pthread_cond_t handover;	// serving has increased
+};
+
+
+void *filepoolthread(void *arg) {
+	struct filepool *P = (struct filepool *) arg;
+	struct outbatch *B, *next, *first, *last;
+	INT k, ticket;
+
+	while(1) {
+		// take the next file unless too many wait for the writer
+		pthread_mutex_lock(&P->mut);
+		while(P->next < P->num && P->next >= P->written + P->window)
+			pthread_cond_wait(&P->progress, &P->mut);
+		// skip the large components that have already been written
+		if(P->next < P->written) P->next = P->written;
+		k = P->next++;
+		B = (k < P->num) ? P->done[k] : NULL;
+		pthread_mutex_unlock(&P->mut);
+		if(k >= P->num) break;
+
+		if(B == NULL) {
+			if(P->files != NULL) B = analysefile(P->comarg, P->files[k], P->inner, k+1);
+			else if(P->roots != NULL) B = analyseroot(P->comarg, P->graphs[0], P->roots[k], k+1);
+			else B = analysegraph(P->comarg, P->graphs[k], P->inner, k+1);
+		}
+
+		// collect all batches that are next in line, they are handed over
+		// without the lock since pushbatch() may wait for the writer
+		first = NULL;
+		last = NULL;
+		pthread_mutex_lock(&P->mut);
+		P->done[k] = B;
+		while(P->written < P->num && P->done[P->written] != NULL) {
+			if(first == NULL) first = P->done[P->written];
+			else last->next = P->done[P->written];
+			for(last = P->done[P->written]; last->next != NULL; last = last->next);
+			P->done[P->written] = NULL;
+			P->written++;
+		}
+		ticket = (first != NULL) ? P->ticket++ : 0;
+		pthread_cond_broadcast(&P->progress);
+		pthread_mutex_unlock(&P->mut);
+		if(first == NULL) continue;
+
+		// the tickets keep the batches in order
+		pthread_mutex_lock(&P->handmut);
+		while(P->serving != ticket)
+			pthread_cond_wait(&P->handover, &P->handmut);
+		pthread_mutex_unlock(&P->handmut);
+		for(B = first; B != NULL; B = next) {
+			next = B->next;
+			pushbatch(&P->Q, B);
+		}
+		pthread_mutex_lock(&P->handmut);
+		P->serving++;
+		pthread_cond_broadcast(&P->handover);
+		pthread_mutex_unlock(&P->handmut);
+	}
+
+	return NULL;
+}
+
+
+// adds the file names listed in listfile, one per line, to *files
+void readfilelist(char *listfile, char ***files, INT *num) {
+	FILE *f;
+	char *line;
+	size_t cap, len;
+	ssize_t r;
+	INT size;
+
+	f = (strcmp(listfile, "-") == 0) ? stdin : fopen(listfile, "r");
+	if(f == NULL) {
+		fprintf(stderr, "Error opening file list %s.\n", listfile);
+		exit(-1);
+	}
+
+	size = *num;
+	line = NULL;
+	cap = 0;
+	while((r = getline(&line, &cap, f)) != -1) {
+		len = (size_t) r;
+		while(len > 0 && (line[len-1] == '\n' || line[len-1] == '\r'))
+			len--;
+		if(len == 0) continue;
+		line[len] = '\0';
+
+		if(*num == size) {
+			size = 2 * size + 1024;
+			*files = (char **) realloc(*files, size * sizeof(char *));
+			if(*files == NULL) {
+				fprintf(stderr, "Memory allocation error in function readfilelist.\n");
+				exit(-1);
+			}
+		}
+		(*files)[*num] = strdup(line);
+		if((*files)[*num] == NULL) {
+			fprintf(stderr, "Memory allocation error in function readfilelist.\n");
+			exit(-1);
+		}
+		(*num)++;
+	}
+
+	free(line);
+	if(f != stdin) fclose(f);
+}
+
+
+/*
+ * Splits the argument of --vertex into the ids of the roots: a comma
+ * separated list, or @FILE with one id per line
+ */
+void rootlist(struct cmdarg *comarg) {
+	char *s, *t;
+	INT k;
+
+	if(comarg->vid == NULL) return;
+
+	if(comarg->vid[0] == '@') {
+		readfilelist(comarg->vid + 1, &comarg->rootid, &comarg->numroots);
+		if(comarg->numroots == 0) {
+			fprintf(stderr, "Error: no root vertices in file %s.\n", comarg->vid + 1);
 			exit(-1);
 		}
-		*/
+		return;
+	}
 
-		H = looptree(G, G->root);
-		if(H) {
-			outgraph(H, comarg->loopfile);
-			free_graph(H);
+	for(s = comarg->vid, k = 1; *s != '\0'; s++)
+		if(*s == ',') k++;
+	comarg->rootid = (char **) malloc(k * sizeof(char *));
+	if(comarg->rootid == NULL) {
+		fprintf(stderr, "Memory allocation error in function rootlist.\n");
+		exit(-1);
+	}
+	for(s = comarg->vid, k = 0; ; s = t + 1) {
+		t = strchr(s, ',');
+		comarg->rootid[k] = (t != NULL) ? strndup(s, t - s) : strdup(s);
+		if(comarg->rootid[k++] == NULL) {
+			fprintf(stderr, "Memory allocation error in function rootlist.\n");
+			exit(-1);
 		}
-	}			
+		if(t == NULL) break;
+	}
+	comarg->numroots = k;
+}
+
+
+/*
+ * Analyses the files (or, if files is NULL, the graphs, or, if roots is not
+ * NULL, the graph graphs[0] with each of the roots) on a pool of threads and
+ * writes their outputs in this order. The graph of the roots is not freed.
+ */
+void runpool(struct cmdarg *comarg, char **files, struct graph **graphs, struct vertex **roots, INT num) {
+	struct filepool P;
+	pthread_t *th;
+	INT nt, k, total;
+
+	/* one thread per file, spare threads help with the files */
+	nt = ((INT) comarg->threads < num) ? (INT) comarg->threads : num;
+	P.comarg = comarg;
+	P.files = files;
+	P.graphs = graphs;
+	P.roots = roots;
+	P.num = num;
+	P.inner = comarg->threads / nt;
+	P.next = 0;
+	P.written = 0;
+	P.ticket = 0;
+	P.serving = 0;
+	P.window = 4 * nt + comarg->queuedepth;
+	P.done = (struct outbatch **) calloc(num, sizeof(struct outbatch *));
+	th = (pthread_t *) calloc(nt, sizeof(pthread_t));
+	if(P.done == NULL || th == NULL) {
+		fprintf(stderr, "Memory allocation error in function runpool.\n");
+		exit(-1);
+	}
+	pthread_mutex_init(&P.mut, NULL);
+	pthread_cond_init(&P.progress, NULL);
+	pthread_mutex_init(&P.handmut, NULL);
+	pthread_cond_init(&P.handover, NULL);
+	startwriter(&P.Q, comarg->queuedepth, (size_t) comarg->queuemem << 20);
+
+	/* the first root gives all outputs that do not depend on the root */
+	if(roots != NULL) {
+		graphs[0]->root = roots[0];
+		P.done[0] = analysegraph(comarg, graphs[0], comarg->threads, 1);
+		P.done[0]->G = NULL;	// the other roots still need the graph
+	}
+
+	/* components with at least a 1/nt fraction of the vertices first */
+	if(files == NULL && roots == NULL && nt > 1) {
+		for(k=0, total=0; k<num; k++)
+			total += graphs[k]->num;
+		for(k=0; k<num; k++) {
+			if(graphs[k]->num * nt >= total)
+				P.done[k] = analysegraph(comarg, graphs[k], comarg->threads, k+1);
+		}
+	}
+
+	for(k=0; k<nt; k++) {
+		if(pthread_create(&th[k], NULL, &filepoolthread, &P)) {
+			fprintf(stderr, "Error launching thread number %"STR(FINT)"\n", k);
+			exit(-1);
+		}
+	}
+	for(k=0; k<nt; k++)
+		pthread_join(th[k], NULL);
+
+	// wait for the remaining outputs
+	stopwriter(&P.Q);
+
+	/* clean up */
+	pthread_mutex_destroy(&P.mut);
+	pthread_cond_destroy(&P.progress);
+	pthread_mutex_destroy(&P.handmut);
+	pthread_cond_destroy(&P.handover);
+	free(P.done);
+	free(th);
+}
+
+
+/*
+ * Read graph from file instead of generating the graph at random. The
+ * components of a disconnected graph are analysed in parallel, the % symbol
+ * of the output file names is replaced by the number of the component.
+ */
+int rfile(struct cmdarg *comarg) {
+	struct graph **C;
+	struct outbatch *B;
+	struct vertex **roots;
+	INT numcomp, k;
+
+	rootlist(comarg);
+	roots = NULL;
+	if(comarg->numroots > 1) {
+		roots = (struct vertex **) malloc(comarg->numroots * sizeof(struct vertex *));
+		if(roots == NULL) {
+			fprintf(stderr, "Memory allocation error in function rfile.\n");
+			exit(-1);
+		}
+	}
+
+	C = graphcomponents(comarg, readgraph(comarg, comarg->infile, roots, comarg->threads), comarg->threads, &numcomp);
+
+	if(roots != NULL) {
+		// the % symbol is replaced by the number of the root
+		comarg->num = (unsigned int) comarg->numroots;
+		comarg->Tnum = 1;
+		runpool(comarg, NULL, C, roots, comarg->numroots);
+		free_graph(C[0]);
+		free(roots);
+	} else if(numcomp == 1) {
+		B = analysegraph(comarg, C[0], comarg->threads, 1);
+		writebatch(B);
+		free(B);
+	} else {
+		comarg->num = (unsigned int) numcomp;
+		comarg->Tnum = 1;
+		runpool(comarg, NULL, C, NULL, numcomp);
+	}
+	free(C);
+
+	for(k=0; k<comarg->numroots; k++)
+		free(comarg->rootid[k]);
+	if(comarg->rootid != NULL) free(comarg->rootid);
+
+	return 0;
+}
+
+
+/*
+ * Analyse the files given as arguments and those in the list of --batch
+ */
+int rbatch(struct cmdarg *comarg) {
+	char **files;
+	INT num, args, k;
+
+	rootlist(comarg);
+	if(comarg->numroots > 1) {
+		fprintf(stderr, "Error: --batch accepts only one root vertex.\n");
+		exit(-1);
+	}
+
+	/* names of the input files */
+	args = comarg->nummerge;
+	num = args;
+	files = (char **) malloc((num + 1) * sizeof(char *));
+	if(files == NULL) {
+		fprintf(stderr, "Memory allocation error in function rbatch.\n");
+		exit(-1);
+	}
+	for(k=0; k<args; k++)
+		files[k] = comarg->mergefiles[k];
+	if(comarg->batchlist != NULL)
+		readfilelist(comarg->batchlist, &files, &num);
+	if(num == 0) {
+		fprintf(stderr, "Error: --batch received no input files.\n");
+		exit(-1);
+	}
+
+	// the % symbol of output file names is replaced by the number of the
+	// input file
+	comarg->num = (unsigned int) num;
+	comarg->Tnum = 1;
 
+	runpool(comarg, files, NULL, NULL, num);
 
 	/* clean up */
-	free_graph(G);
+	for(k=args; k<num; k++)
+		free(files[k]);
+	free(files);
+	for(k=0; k<comarg->numroots; k++)
+		free(comarg->rootid[k]);
+	if(comarg->rootid != NULL) free(comarg->rootid);
 
 	return 0;
 }
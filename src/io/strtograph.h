@@ -1,206 +1,480 @@
 /*
  *
- * We use a simple hashmap to build a graph structure out of a list of vertices
- * and edges that are given by strings and pairs of strings, respectively.
+ * We build a graph structure out of vertices and edges that are given by
+ * strings and pairs of strings, respectively.
+ *
+ * Every distinct identifier is copied once into an arena and receives a
+ * small integer, its symbol. An open addressing hash table maps strings to
+ * symbols. Edges are recorded as pairs of symbols while the input is parsed
+ * and sorted into a compressed sparse row structure (struct csr) at the end,
+ * from which csr2graph() builds the graph.
+ *
+ * Usage:
+ *		gbinit(&B);
+ *		gbnode(&B, "a", 1);
+ *		gbnode(&B, "b", 1);
+ *		gbedge(&B, "a", 1, "b", 1);
+ *		gbkey(&B, "d0", 2, "height", 6);	// <key id='d0' attr.name='height'>
+ *		gbdata(&B, "d0", 2, "1", 1);		// <data key='d0'>1</data> of "b"
+ *		G = gbgraph(&B, R);			// also frees the builder
  *
  */
 
 
+#define ARENABLOCK (1UL << 20)	// minimal size of a block of the arena
+#define NOSYMBOL ((INT) -1)		// marks empty slots of the hash table
+#define NOVERTEX ((INT) -1)		// symbol that was not declared by a <node>
+#define NOVALUE ((INTD) -1)		// attribute that was not given
 
-/*
- * Temporary and inefficient data structure for a graph
- * Vertices are given by a list of strings
- * Edges are given by a list of pairs of strings
- *
- * Use for I/O purposes only
- */
 
-struct elist {
-	char *source;
-	char *target;
-	struct elist *next;
+// a block of memory for the interned strings
+struct arenablock {
+	struct arenablock *next;
+	size_t used;
+	size_t cap;
+	char data[];
 };
 
-struct vlist {
-	INT id;
-	char *ident;
-	struct vlist *next;
+// table of interned strings
+struct strtable {
+	struct arenablock *arena;	// blocks that hold the strings
+	char **key;					// key[s] is the string of symbol s
+	INT *vid;					// vid[s] is the vertex id of symbol s
+	INT num;					// number of symbols
+	INT cap;					// capacity of key and vid
+	INT *slot;					// hash table, contains symbols or NOSYMBOL
+	INT size;					// number of slots, a power of two
+	int bits;					// size = 2^bits
 };
 
-struct strgraph {
-	struct vlist *vstart;
-	struct vlist *vend;
-	struct elist *estart;
-	struct elist *eend;
+// an edge given by the symbols of its end points
+struct edgepair {
+	INT source;
+	INT target;
 };
 
-
-struct bucket {
-	struct vlist *vstart;
-	struct vlist *vend;
+// collects vertices and edges until the graph is built
+struct graphbuilder {
+	struct strtable T;
+	struct edgepair *e;		// directed edges in the order of the input
+	INT nume;				// number of edges
+	INT cape;				// capacity of e
+	INT numv;				// number of declared vertices
+	char *keyid[GATTRNUM];	// ids of the <key>s of the known vertex
+							// attributes (or NULL)
+	INTD *attr[GATTRNUM];	// attr[k][v] is attribute k of vertex v, the
+							// symbol of the identifier for the parent
+	INT capa;				// capacity of the attr arrays
 };
 
-void push2bucket(struct bucket *B, struct vlist *vert) {
-	struct vlist *v;
 
-	// create copy of vertex
-	v = (struct vlist *) malloc(sizeof(struct vlist));
-	if(v == NULL) {
-		fprintf(stderr, "Error allocating memory for hashmap");
-		exit(-1);
+unsigned long long djb2hash(const char *str, size_t len) {
+	unsigned long long hash = 5381;
+	size_t i;
+
+	for(i=0; i<len; i++) {
+		hash = ((hash << 5) + hash) + (unsigned char) str[i]; // hash*33 + c
 	}
-	v->next = NULL;
-	v->ident = (char *) malloc(sizeof(char)*(strlen(vert->ident) + 1));
-	if(v->ident == NULL) {
-		fprintf(stderr, "Error allocating memory for hashmap.\n");
-		exit(-1);
+
+	// spread the bits, similar identifiers like "n17" and "n18" would
+	// otherwise end up in neighbouring slots
+	return hash * 0x9E3779B97F4A7C15ULL;
+}
+
+
+// first slot to probe for a string with hash value h
+INT firstslot(struct strtable *T, unsigned long long h) {
+	return (INT) (h >> (64 - T->bits));
+}
+
+
+// copy a string of length len into the arena
+char *arenacopy(struct strtable *T, const char *str, size_t len) {
+	struct arenablock *b = T->arena;
+	char *res;
+
+	if(b == NULL || b->used + len + 1 > b->cap) {
+		b = (struct arenablock *) malloc(sizeof(struct arenablock) + ((len + 1 > ARENABLOCK) ? len + 1 : ARENABLOCK));
+		if(b == NULL) {
+			fprintf(stderr, "Error allocating memory for string table.\n");
+			exit(-1);
+		}
+		b->used = 0;
+		b->cap = (len + 1 > ARENABLOCK) ? len + 1 : ARENABLOCK;
+		b->next = T->arena;
+		T->arena = b;
 	}
-	strcpy(v->ident, vert->ident);
-	v->id = vert->id;
+
+	res = b->data + b->used;
+	memcpy(res, str, len);
+	res[len] = '\0';
+	b->used += len + 1;
+
+	return res;
+}
 
 
-	// put vertex into bucket
-	if(B->vstart == NULL) {
-		B->vstart = v;
-		B->vend = v;
-	} else {
-		B->vend->next = v;
-		B->vend = v;
+// doubles the number of slots of the hash table
+void rehash(struct strtable *T) {
+	INT i, s;
+
+	free(T->slot);
+	T->size *= 2;
+	T->bits++;
+	T->slot = (INT *) malloc(T->size * sizeof(INT));
+	if(T->slot == NULL) {
+		fprintf(stderr, "Error allocating memory for string table.\n");
+		exit(-1);
+	}
+	for(i=0; i<T->size; i++)
+		T->slot[i] = NOSYMBOL;
+
+	for(s=0; s<T->num; s++) {
+		i = firstslot(T, djb2hash(T->key[s], strlen(T->key[s])));
+		while(T->slot[i] != NOSYMBOL)
+			i = (i + 1) & (T->size - 1);
+		T->slot[i] = s;
 	}
 }
 
 
-unsigned long long djb2hash(char *str, INT modulo) {
-	unsigned long long hash = 5381;
-	int c;
+/*
+ * Returns the symbol of the string str of length len with hash value
+ * h = djb2hash(str, len). If insert is nonzero, unknown strings receive a
+ * new symbol, otherwise NOSYMBOL is returned.
+ */
+INT internhash(struct strtable *T, const char *str, size_t len, unsigned long long h, int insert) {
+	INT i, s;
 
-	while( (c = *str++) ) {
-		hash = ((hash << 5) + hash) + c; // hash*33 + c
+	for(i = firstslot(T, h); T->slot[i] != NOSYMBOL; i = (i + 1) & (T->size - 1)) {
+		s = T->slot[i];
+		if(memcmp(T->key[s], str, len) == 0 && T->key[s][len] == '\0') return s;
+	}
+	if(!insert) return NOSYMBOL;
+
+	// new symbol
+	if(T->num == T->cap) {
+		T->cap *= 2;
+		T->key = (char **) realloc(T->key, T->cap * sizeof(char *));
+		T->vid = (INT *) realloc(T->vid, T->cap * sizeof(INT));
+		if(T->key == NULL || T->vid == NULL) {
+			fprintf(stderr, "Error allocating memory for string table.\n");
+			exit(-1);
+		}
 	}
+	s = T->num;
+	T->key[s] = arenacopy(T, str, len);
+	T->vid[s] = NOVERTEX;
+	T->slot[i] = s;
+	T->num++;
 
-	return hash % modulo;
+	// keep the load factor below 1/2
+	if(2 * T->num > T->size) rehash(T);
+
+	return s;
 }
 
-// this function returns id of the vertex with identifier string *str
-// if such a vertex does not exist, it returns -1
-int getid(char *str, struct bucket *bucketlist, INT len) {
-	struct vlist *v;
-	INT bucketnumber = djb2hash(str,len);
 
-	if(bucketnumber >= len) {
-		fprintf(stderr, "Error looking for a vertex in the hashmap.\n");	
+INT intern(struct strtable *T, const char *str, size_t len, int insert) {
+	return internhash(T, str, len, djb2hash(str, len), insert);
+}
+
+
+void gbinit(struct graphbuilder *B) {
+	INT i;
+
+	B->T.arena = NULL;
+	B->T.num = 0;
+	B->T.cap = 1024;
+	B->T.size = 2048;
+	B->T.bits = 11;
+	B->T.key = (char **) malloc(B->T.cap * sizeof(char *));
+	B->T.vid = (INT *) malloc(B->T.cap * sizeof(INT));
+	B->T.slot = (INT *) malloc(B->T.size * sizeof(INT));
+
+	B->nume = 0;
+	B->cape = 1024;
+	B->numv = 0;
+	B->e = (struct edgepair *) malloc(B->cape * sizeof(struct edgepair));
+
+	for(i=0; i<GATTRNUM; i++) {
+		B->keyid[i] = NULL;
+		B->attr[i] = NULL;
+	}
+	B->capa = 0;
+
+	if(B->T.key == NULL || B->T.vid == NULL || B->T.slot == NULL || B->e == NULL) {
+		fprintf(stderr, "Error allocating memory for graph builder.\n");
 		exit(-1);
 	}
+	for(i=0; i<B->T.size; i++)
+		B->T.slot[i] = NOSYMBOL;
+}
 
-	for(v = bucketlist[bucketnumber].vstart; v != NULL; v = v->next)
-		if( strcmp(v->ident, str) == 0) return v->id;
 
-	return -1;		// vertex not found
+void gbfree(struct graphbuilder *B) {
+	struct arenablock *b, *tmp;
+	int k;
+
+	for(k=0; k<GATTRNUM; k++) {
+		if(B->keyid[k] != NULL) free(B->keyid[k]);
+		if(B->attr[k] != NULL) free(B->attr[k]);
+	}
+
+	for(b = B->T.arena; b != NULL; b = tmp) {
+		tmp = b->next;
+		free(b);
+	}
+	free(B->T.key);
+	free(B->T.vid);
+	free(B->T.slot);
+	if(B->e != NULL) free(B->e);
 }
 
-void emptybuckets(struct bucket *bucketlist, INT len) {
-	INT i;
-	struct vlist *v;
-	struct vlist *tmpv;
 
-	for(i=0; i<len; i++) {
-		v = bucketlist[i].vstart;
-		while(v) {
-			tmpv = v->next;
-			free(v->ident);
-			free(v);
-			v = tmpv;
+// declare a vertex, vertices receive ids in the order of declaration
+// if an identifier is declared twice, it refers to the first vertex
+// h is the hash value of the identifier
+void gbnodehash(struct graphbuilder *B, const char *ident, size_t len, unsigned long long h) {
+	INT s = internhash(&B->T, ident, len, h, 1);
+
+	if(B->T.vid[s] == NOVERTEX) B->T.vid[s] = B->numv;
+	B->numv++;
+}
+
+void gbnode(struct graphbuilder *B, const char *ident, size_t len) {
+	gbnodehash(B, ident, len, djb2hash(ident, len));
+}
+
+
+// add a directed edge, the end points may be declared later on
+// sh and th are the hash values of source and target
+void gbdiedgehash(struct graphbuilder *B, const char *source, size_t slen, unsigned long long sh, const char *target, size_t tlen, unsigned long long th) {
+	if(B->nume == B->cape) {
+		B->cape *= 2;
+		B->e = (struct edgepair *) realloc(B->e, B->cape * sizeof(struct edgepair));
+		if(B->e == NULL) {
+			fprintf(stderr, "Error allocating memory for graph builder.\n");
+			exit(-1);
 		}
 	}
-	free(bucketlist);
+	B->e[B->nume].source = internhash(&B->T, source, slen, sh, 1);
+	B->e[B->nume].target = internhash(&B->T, target, tlen, th, 1);
+	B->nume++;
 }
 
-struct bucket *ini_buckets(struct strgraph *H) {
-	INT i;
-	INT len = H->vend->id + 1;
-	struct vlist *v;
-	struct bucket *bucketlist;
-
-	// create and initialize list of buckets	
-	bucketlist = (struct bucket *) calloc(sizeof(struct bucket), len);
-	if(bucketlist == NULL) {
-		fprintf(stderr, "Error allocating memory for hashmap.");
-		exit(-1);
+void gbdiedge(struct graphbuilder *B, const char *source, size_t slen, const char *target, size_t tlen) {
+	gbdiedgehash(B, source, slen, djb2hash(source, slen), target, tlen, djb2hash(target, tlen));
+}
+
+
+// add an undirected edge
+void gbedge(struct graphbuilder *B, const char *source, size_t slen, const char *target, size_t tlen) {
+	gbdiedge(B, source, slen, target, tlen);
+	gbdiedge(B, target, tlen, source, slen);
+}
+
+
+// declare the <key> with the given id for the attribute name, only the
+// attributes written by print_graphmlattr() are read
+void gbkey(struct graphbuilder *B, const char *id, size_t idlen, const char *name, size_t nlen) {
+	int k;
+
+	for(k=0; k<GATTRNUM; k++) {
+		if(strlen(gattrnames[k]) == nlen && memcmp(gattrnames[k], name, nlen) == 0) {
+			if(B->keyid[k] != NULL) free(B->keyid[k]);
+			B->keyid[k] = (char *) malloc(idlen + 1);
+			if(B->keyid[k] == NULL) {
+				fprintf(stderr, "Error allocating memory for graph builder.\n");
+				exit(-1);
+			}
+			memcpy(B->keyid[k], id, idlen);
+			B->keyid[k][idlen] = '\0';
+		}
 	}
-	for(i=0; i<len; i++) {
-		bucketlist[i].vstart = NULL;
-		bucketlist[i].vend = NULL;
+}
+
+
+// value of the <data> element with the given key of the last declared
+// vertex, unknown keys and malformed values are ignored
+void gbdata(struct graphbuilder *B, const char *key, size_t klen, const char *val, size_t vlen) {
+	INT v, i, cap;
+	INTD x;
+	int k, j;
+
+	for(k=0; k<GATTRNUM; k++) {
+		if(B->keyid[k] != NULL && strlen(B->keyid[k]) == klen && memcmp(B->keyid[k], key, klen) == 0) break;
 	}
+	if(k == GATTRNUM || B->numv == 0) return;
+	v = B->numv - 1;
 
-	// push vertices into buckets
-	for( v = H->vstart; v != NULL; v = v->next) {
-		push2bucket(&bucketlist[djb2hash(v->ident, len)], v);
+	// strip white space
+	while(vlen > 0 && (*val == ' ' || *val == '\t' || *val == '\n' || *val == '\r')) {
+		val++;
+		vlen--;
+	}
+	while(vlen > 0 && (val[vlen-1] == ' ' || val[vlen-1] == '\t' || val[vlen-1] == '\n' || val[vlen-1] == '\r'))
+		vlen--;
+	if(vlen == 0) return;
+
+	if(v >= B->capa) {
+		cap = (2 * B->capa > v + 1) ? 2 * B->capa : v + 1;
+		if(cap < 1024) cap = 1024;
+		for(j=0; j<GATTRNUM; j++) {
+			B->attr[j] = (INTD *) realloc(B->attr[j], cap * sizeof(INTD));
+			if(B->attr[j] == NULL) {
+				fprintf(stderr, "Error allocating memory for graph builder.\n");
+				exit(-1);
+			}
+			for(i=B->capa; i<cap; i++)
+				B->attr[j][i] = NOVALUE;
+		}
+		B->capa = cap;
 	}
 
-	return bucketlist;
+	if(k == 3) {
+		// the parent is given by its identifier
+		B->attr[k][v] = intern(&B->T, val, vlen, 1);
+		return;
+	}
+
+	for(x=0, i=0; i<vlen; i++) {
+		if(val[i] < '0' || val[i] > '9' || x > (NOVALUE - 10) / 10) return;
+		x = 10 * x + (INTD) (val[i] - '0');
+	}
+	B->attr[k][v] = x;
 }
 
-struct graph *ini_graph(struct strgraph *H, struct bucket *bucketlist, char *rootid) {
-	struct graph *G;
-	struct elist *e;
-	INT source;
-	INT target;
-	INT len = H->vend->id + 1;
 
+/*
+ * Sets the attributes that were given for all vertices. The root becomes
+ * the only vertex without a parent unless roots are given.
+ */
+void gbattributes(struct graphbuilder *B, struct graph *G, struct roots *R) {
+	INT v, r, cnt;
+	int k;
+
+	if(B->capa < B->numv) return;
 
-	// initialize graph
-	G = newgraph(len);
+	for(k=0; k<3; k++) {
+		for(v=0; v<B->numv && B->attr[k][v] != NOVALUE; v++);
+		if(v < B->numv) continue;
 
-	// add edges	
-	for(e = H->estart; e!= NULL; e = e->next) {
-		source = getid(e->source, bucketlist, len);
-		target = getid(e->target, bucketlist, len);
-		
-		// we need to check if these vertices were actually found
-		if( source != -1 && target != -1) {
-			addDiEdge(G->arr[source], G->arr[target]);
+		for(v=0; v<B->numv; v++) {
+			if(k == 0) G->arr[v]->deg = (INT) B->attr[k][v];
+			else if(k == 1) G->arr[v]->height = (INT) B->attr[k][v];
+			else G->arr[v]->cent = B->attr[k][v];
 		}
+		G->attr |= 1 << k;
 	}
 
-	//specify root vertex
-	if(rootid) {
-		source = getid(rootid, bucketlist, len);
-		if( source == -1) {
-			fprintf(stderr, "Error: could not find specified root vertex id in input file.\n");
-			exit(-1);
+	// parents have to be declared vertices
+	for(v=0, cnt=0, r=0; v<B->numv; v++) {
+		if(B->attr[3][v] == NOVALUE) {
+			r = v;
+			cnt++;
+		} else if(B->T.vid[B->attr[3][v]] == NOVERTEX) {
+			break;
 		}
-		G->root = G->arr[source];
 	}
-
-	return G;
+	if(v == B->numv && cnt == 1) {
+		G->attr |= GATTR_PARENT;
+		if(R == NULL) G->root = G->arr[r];
+	}
 }
 
 
-struct graph *make_graph(struct strgraph *H, char *rootid) {
-	struct bucket *bucketlist;		// the hashmap
-	struct graph *G;
+/*
+ * Sorts the edges by source (stable, so every neighbourhood list keeps the
+ * order of the input). Edges with an end point that no <node> declared,
+ * for example one in a nested <graph>, are dropped. Frees the edge list.
+ */
+struct csr *gbcsr(struct graphbuilder *B) {
+	struct csr *C;
+	INT i, s, t, num;
+
+	num = B->numv;
+	C = (struct csr *) malloc(sizeof(struct csr));
+	if(C == NULL) {
+		fprintf(stderr, "Error allocating memory for graph builder.\n");
+		exit(-1);
+	}
+	C->num = num;
 
+	// counting sort: first count the edges of vertex v in off[v+2], after
+	// the prefix sums off[v+1] is the position of the next edge of v
+	C->off = (INT *) calloc(num + 2, sizeof(INT));
+	if(C->off == NULL) {
+		fprintf(stderr, "Error allocating memory for graph builder.\n");
+		exit(-1);
+	}
+	for(i=0; i<B->nume; i++) {
+		s = B->T.vid[B->e[i].source];
+		t = B->T.vid[B->e[i].target];
+		if(s != NOVERTEX && t != NOVERTEX) C->off[s+2]++;
+	}
+	for(i=2; i<num+2; i++)
+		C->off[i] += C->off[i-1];
 
-	// sanity check: exit if graph is empty
-	if( H == NULL ) {
-		fprintf(stderr, "Error: received empty graph\n");
+	C->adj = (INT *) malloc((C->off[num+1] + 1) * sizeof(INT));
+	if(C->adj == NULL) {
+		fprintf(stderr, "Error allocating memory for graph builder.\n");
 		exit(-1);
 	}
-	if( H->vstart == NULL || H->vend == NULL) {
+	for(i=0; i<B->nume; i++) {
+		s = B->T.vid[B->e[i].source];
+		t = B->T.vid[B->e[i].target];
+		if(s != NOVERTEX && t != NOVERTEX) C->adj[ C->off[s+1]++ ] = t;
+	}
+
+	free(B->e);
+	B->e = NULL;
+
+	return C;
+}
+
+
+void free_csr(struct csr *C) {
+	free(C->off);
+	free(C->adj);
+	free(C);
+}
+
+
+/*
+ * Builds the graph and finds the vertices with the identifiers in R (if not
+ * NULL), the first one becomes the root. Frees the builder.
+ */
+struct graph *gbgraph(struct graphbuilder *B, struct roots *R) {
+	struct csr *C;
+	struct graph *G;
+	INT s, k;
+
+	// sanity check: exit if graph is empty
+	if(B->numv == 0) {
 		fprintf(stderr, "Error: received empty graph\n");
 		exit(-1);
 	}
 
-	INT len = H->vend->id + 1;
+	C = gbcsr(B);
+	G = csr2graph(C);
+	free_csr(C);
 
-	// initialize hashmap
-	bucketlist = ini_buckets(H);
+	// vertex attributes from <data> elements
+	gbattributes(B, G, R);
 
-	// create graph structure
-	G = ini_graph(H, bucketlist, rootid);
+	//specify root vertices
+	for(k=0; R != NULL && k<R->num; k++) {
+		s = intern(&B->T, R->id[k], strlen(R->id[k]), 0);
+		if(s == NOSYMBOL || B->T.vid[s] == NOVERTEX) {
+			fprintf(stderr, "Error: could not find specified root vertex id in input file.\n");
+			exit(-1);
+		}
+		R->v[k] = G->arr[B->T.vid[s]];
+	}
+	if(R != NULL) G->root = R->v[0];
 
-	// free allocated memory for hashmap
-	emptybuckets(bucketlist, len);
+	gbfree(B);
 
 	return G;
 }
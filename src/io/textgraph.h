@@ -0,0 +1,450 @@
+/*
+ * Edge lists, METIS and DIMACS graph files
+ *
+ * The format of an input file is chosen by its name (a trailing .gz or .zst
+ * is ignored), files whose first non-blank character is "<" are graphml:
+ *
+ *		.edges .el .txt .tsv	one edge "u v" per line, further columns are
+ *								ignored, lines starting with # or % are
+ *								comments. The vertex ids are non-negative
+ *								integers, the vertices are numbered in the
+ *								order of increasing ids.
+ *		.graph .metis			METIS: a header "n m [fmt [ncon]]", then line
+ *								v lists the neighbours of vertex v (counting
+ *								from 1), possibly with vertex sizes, vertex
+ *								and edge weights (which are skipped).
+ *		.gr .col .dimacs		DIMACS: a line "p FORMAT n m", arcs "a u v
+ *								[w]" and edges "e u v [w]" with vertices
+ *								counting from 1, comment lines start with c.
+ *
+ * Lines of edge lists and "e" lines are undirected edges, "a" lines are
+ * directed arcs (road networks list both directions). The neighbourhood lists
+ * keep the order of the file, just like for graphml files.
+ *
+ * The file is mapped into memory (compressed files are decompressed into
+ * memory) and split into chunks of whole lines that are parsed in parallel.
+ * The edges go straight into a compressed sparse row structure, vertex ids
+ * are numbers and need no interning.
+ */
+
+
+#define TGEDGELIST 1
+#define TGMETIS 2
+#define TGDIMACS 3
+
+#define TGMINCHUNK (1UL << 22)	// minimal number of bytes per thread
+
+
+// a part of the file, parsed by one thread
+struct tgchunk {
+	const char *start;
+	const char *end;
+	int format;
+	int fmt;			// METIS: 1 edge weights, 10 vertex weights, 100 sizes
+	INT ncon;			// METIS: number of vertex weights
+	INT *e;				// directed edges as pairs source, target; for METIS
+	INT nume;			// the source is the line within the chunk
+	INT cape;
+	INT lines;			// METIS: number of vertex lines
+	INT nonempty;		// METIS: number of the last nonempty line + 1
+	INT max;			// largest vertex id (edge lists)
+	const char *bad;	// first malformed line or NULL
+};
+
+
+// format of the input file, 0 if it is none of the above. The name is not
+// enough for files like graph.txt, a file starting with "<" is graphml.
+int textgraphformat(char *infile) {
+	char head[256];
+	size_t n, i;
+	int format;
+
+	format = 0;
+	if(hasformat(infile, ".edges") || hasformat(infile, ".el") || hasformat(infile, ".txt") || hasformat(infile, ".tsv")) format = TGEDGELIST;
+	else if(hasformat(infile, ".graph") || hasformat(infile, ".metis")) format = TGMETIS;
+	else if(hasformat(infile, ".gr") || hasformat(infile, ".col") || hasformat(infile, ".dimacs")) format = TGDIMACS;
+	if(format == 0) return 0;
+
+	// the first byte that is not blank (after a UTF-8 byte order mark)
+	n = inputhead(infile, head, sizeof(head));
+	i = (n >= 3 && memcmp(head, "\xef\xbb\xbf", 3) == 0) ? 3 : 0;
+	while(i < n && (head[i] == ' ' || head[i] == '\t' || head[i] == '\r' || head[i] == '\n')) i++;
+	if(i < n && head[i] == '<') return 0;
+
+	return format;
+}
+
+
+// skips blanks (but not line breaks)
+const char *tgblank(const char *p, const char *end) {
+	while(p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == ',')) p++;
+	return p;
+}
+
+
+// reads a decimal number at p, returns NULL if there is none
+const char *tgnumber(const char *p, const char *end, INT *x) {
+	const char *q = p;
+
+	*x = 0;
+	while(p < end && *p >= '0' && *p <= '9') {
+		if(*x > ((INT) -1 - 9) / 10) return NULL;
+		*x = 10 * *x + (INT) (*p - '0');
+		p++;
+	}
+	if(p == q || (p < end && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' && *p != ',')) return NULL;
+
+	return p;
+}
+
+
+void tgpush(struct tgchunk *c, INT s, INT t) {
+	if(c->nume + 2 > c->cape) {
+		c->cape = (c->cape == 0) ? 1024 : 2 * c->cape;
+		c->e = (INT *) realloc(c->e, c->cape * sizeof(INT));
+		if(c->e == NULL) {
+			fprintf(stderr, "Memory allocation error in function tgpush.\n");
+			exit(-1);
+		}
+	}
+	c->e[c->nume++] = s;
+	c->e[c->nume++] = t;
+}
+
+
+// parses one line from p to end, the line break excluded
+// returns 0 if the line is malformed
+int tgline(struct tgchunk *c, const char *p, const char *end) {
+	INT u, v, k, skip;
+	int undirected;
+
+	p = tgblank(p, end);
+
+	switch(c->format) {
+		case TGEDGELIST:
+			if(p == end || *p == '#' || *p == '%') return 1;
+			if((p = tgnumber(p, end, &u)) == NULL) return 0;
+			if((p = tgnumber(tgblank(p, end), end, &v)) == NULL) return 0;
+			if(u > c->max) c->max = u;
+			if(v > c->max) c->max = v;
+			tgpush(c, u, v);
+			tgpush(c, v, u);
+			return 1;
+
+		case TGDIMACS:
+			if(p == end || *p == 'c' || *p == 'p' || *p == '%' || *p == '#') return 1;
+			if(*p != 'a' && *p != 'e') return 0;
+			undirected = (*p == 'e');
+			p = tgblank(p + 1, end);
+			if((p = tgnumber(p, end, &u)) == NULL) return 0;
+			if((p = tgnumber(tgblank(p, end), end, &v)) == NULL) return 0;
+			if(u > c->max) c->max = u;
+			if(v > c->max) c->max = v;
+			tgpush(c, u, v);
+			if(undirected) tgpush(c, v, u);
+			return 1;
+
+		case TGMETIS:
+			if(p < end && *p == '%') return 1;
+			// vertex size and weights first
+			skip = ((c->fmt / 100) % 10 ? 1 : 0) + ((c->fmt / 10) % 10 ? c->ncon : 0);
+			for(k=0; p < end; k++) {
+				if((p = tgnumber(p, end, &v)) == NULL) return 0;
+				p = tgblank(p, end);
+				if(k < skip) continue;
+				// every neighbour may be followed by the weight of the edge
+				if((c->fmt % 10) && (k - skip) % 2 == 1) continue;
+				tgpush(c, c->lines, v);
+			}
+			if((c->fmt % 10) && k > skip && (k - skip) % 2 == 1) return 0;
+			if(k > 0) c->nonempty = c->lines + 1;
+			c->lines++;
+			return 1;
+	}
+
+	return 0;
+}
+
+
+// thread that parses one chunk
+void *tgparse(void *arg) {
+	struct tgchunk *c = (struct tgchunk *) arg;
+	const char *p, *q;
+
+	for(p = c->start; p < c->end; p = q + 1) {
+		q = memchr(p, '\n', c->end - p);
+		if(q == NULL) q = c->end;
+		if(!tgline(c, p, q)) {
+			c->bad = p;
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+
+// the header line of METIS and DIMACS files, returns the position after it
+const char *tgheader(const char *p, const char *end, int format, INT *n, int *fmt, INT *ncon) {
+	const char *q;
+	INT m, x;
+
+	*fmt = 0;
+	*ncon = 1;
+	for(; p < end; p = q + 1) {
+		q = memchr(p, '\n', end - p);
+		if(q == NULL) q = end;
+		p = tgblank(p, q);
+
+		if(format == TGMETIS) {
+			if(p == q || *p == '%') continue;
+			if((p = tgnumber(p, q, n)) == NULL || (p = tgnumber(tgblank(p, q), q, &m)) == NULL) return NULL;
+			p = tgblank(p, q);
+			if(p < q) {
+				if((p = tgnumber(p, q, &x)) == NULL) return NULL;
+				*fmt = (int) (x % 1000);
+				p = tgblank(p, q);
+				if(p < q && ((p = tgnumber(p, q, ncon)) == NULL || *ncon == 0)) return NULL;
+			}
+			return (q < end) ? q + 1 : q;
+		} else {
+			// everything before the problem line has to be a comment
+			if(p == q || *p == 'c') continue;
+			if(*p != 'p') return NULL;
+			p = tgblank(p + 1, q);
+			while(p < q && *p != ' ' && *p != '\t') p++;
+			if((p = tgnumber(tgblank(p, q), q, n)) == NULL) return NULL;
+			return (q < end) ? q + 1 : q;
+		}
+	}
+
+	return NULL;
+}
+
+
+int tgcompare(const void *a, const void *b) {
+	INT x = *(const INT *) a, y = *(const INT *) b;
+
+	return (x > y) - (x < y);
+}
+
+
+/*
+ * Reads a graph from an edge list, METIS or DIMACS file using numThreads
+ * threads. Returns NULL if the name of infile has none of the suffixes of
+ * these formats. The roots in R are given by their ids (for METIS and DIMACS
+ * the numbers of the vertices, counting from 1), the root of the graph is
+ * the first of them.
+ */
+struct graph *readtextgraph(char *infile, struct roots *R, INT numThreads) {
+	size_t len;
+	char *end;
+	const char *map, *body, *p;
+	struct tgchunk *chunks;
+	pthread_t *th;
+	struct csr C;
+	struct graph *G;
+	INT n, k, i, nt, s, t, numid, *idmap, *ids, *hit, *base, ncon, root;
+	int format, fmt, mapped;
+
+	format = textgraphformat(infile);
+	if(format == 0) return NULL;
+
+	/* map the file, or decompress it into memory */
+	map = mapinput(infile, &len, &mapped);
+	end = (char *) map + len;
+
+	/* header of METIS and DIMACS files */
+	n = 0;
+	fmt = 0;
+	ncon = 1;
+	body = map;
+	if(format != TGEDGELIST) {
+		body = tgheader(map, end, format, &n, &fmt, &ncon);
+		if(body == NULL) {
+			fprintf(stderr, "Error: %s has no valid header line.\n", infile);
+			exit(-1);
+		}
+	}
+
+	/* split into chunks of whole lines and parse them in parallel */
+	nt = (end - body) / TGMINCHUNK;
+	if(nt > numThreads) nt = numThreads;
+	if(nt < 1) nt = 1;
+	chunks = (struct tgchunk *) calloc(nt, sizeof(struct tgchunk));
+	th = (pthread_t *) calloc(nt, sizeof(pthread_t));
+	if(chunks == NULL || th == NULL) {
+		fprintf(stderr, "Memory allocation error in function readtextgraph.\n");
+		exit(-1);
+	}
+	for(k=0; k<nt; k++) {
+		p = (k == 0) ? body : body + k * ((end - body) / nt);
+		if(k > 0) {
+			if(p < chunks[k-1].start) p = chunks[k-1].start;
+			p = memchr(p, '\n', end - p);
+			p = (p == NULL) ? end : p + 1;
+			chunks[k-1].end = p;
+		}
+		chunks[k].start = p;
+		chunks[k].format = format;
+		chunks[k].fmt = fmt;
+		chunks[k].ncon = ncon;
+	}
+	chunks[nt-1].end = end;
+
+	for(k=0; k<nt; k++) {
+		if(pthread_create(&th[k], NULL, &tgparse, &chunks[k])) {
+			fprintf(stderr, "Error launching thread number %"STR(FINT)"\n", k);
+			exit(-1);
+		}
+	}
+	for(k=0; k<nt; k++)
+		pthread_join(th[k], NULL);
+
+	for(k=0; k<nt; k++) {
+		if(chunks[k].bad != NULL) {
+			p = memchr(chunks[k].bad, '\n', end - chunks[k].bad);
+			fprintf(stderr, "Error: malformed line in %s: %.*s\n", infile, (int) (((p == NULL) ? end : p) - chunks[k].bad), chunks[k].bad);
+			exit(-1);
+		}
+	}
+
+	/* number of vertices and the vertex of each id */
+	idmap = NULL;
+	ids = NULL;
+	numid = 0;
+	base = (INT *) calloc(nt + 1, sizeof(INT));
+	if(base == NULL) {
+		fprintf(stderr, "Memory allocation error in function readtextgraph.\n");
+		exit(-1);
+	}
+	if(format == TGEDGELIST) {
+		// the ids that occur, in increasing order
+		for(k=0, s=0, t=0; k<nt; k++) {
+			if(chunks[k].nume > 0 && chunks[k].max >= s) s = chunks[k].max + 1;
+			t += chunks[k].nume;
+		}
+		if(s <= 4 * t + 1024) {
+			idmap = (INT *) calloc(s + 1, sizeof(INT));
+			if(idmap == NULL) {
+				fprintf(stderr, "Memory allocation error in function readtextgraph.\n");
+				exit(-1);
+			}
+			for(k=0; k<nt; k++)
+				for(i=0; i<chunks[k].nume; i++)
+					idmap[chunks[k].e[i]] = 1;
+			for(i=0, n=0; i<s; i++)
+				idmap[i] = idmap[i] ? n++ : NOVERTEX;
+		} else {
+			// few vertices with large ids
+			ids = (INT *) malloc((t + 1) * sizeof(INT));
+			if(ids == NULL) {
+				fprintf(stderr, "Memory allocation error in function readtextgraph.\n");
+				exit(-1);
+			}
+			for(k=0, t=0; k<nt; k++)
+				for(i=0; i<chunks[k].nume; i++)
+					ids[t++] = chunks[k].e[i];
+			qsort(ids, t, sizeof(INT), &tgcompare);
+			for(i=0, n=0; i<t; i++)
+				if(i == 0 || ids[i] != ids[i-1]) ids[n++] = ids[i];
+		}
+		numid = s;
+	} else if(format == TGMETIS) {
+		// vertex lines after the n-th one have to be empty
+		for(k=0; k<nt; k++) {
+			base[k+1] = base[k] + chunks[k].lines;
+			if(chunks[k].nonempty > 0 && base[k] + chunks[k].nonempty > n) {
+				fprintf(stderr, "Error: %s has more vertex lines than vertices.\n", infile);
+				exit(-1);
+			}
+		}
+		if(base[nt] < n) {
+			fprintf(stderr, "Error: %s has less vertex lines than vertices.\n", infile);
+			exit(-1);
+		}
+	}
+	if(n == 0) {
+		fprintf(stderr, "Error: received empty graph\n");
+		exit(-1);
+	}
+
+	/* compressed sparse row structure, sorted by source like gbcsr() */
+	C.num = n;
+	C.off = (INT *) calloc(n + 2, sizeof(INT));
+	for(k=0, t=0; k<nt; k++)
+		t += chunks[k].nume / 2;
+	C.adj = (INT *) malloc((t + 1) * sizeof(INT));
+	if(C.off == NULL || C.adj == NULL) {
+		fprintf(stderr, "Memory allocation error in function readtextgraph.\n");
+		exit(-1);
+	}
+	for(k=0; k<nt; k++) {
+		for(i=0; i<chunks[k].nume; i += 2) {
+			s = chunks[k].e[i];
+			t = chunks[k].e[i+1];
+			if(format == TGEDGELIST) {
+				if(idmap != NULL) {
+					s = idmap[s];
+					t = idmap[t];
+				} else {
+					s = (INT *) bsearch(&s, ids, n, sizeof(INT), &tgcompare) - ids;
+					t = (INT *) bsearch(&t, ids, n, sizeof(INT), &tgcompare) - ids;
+				}
+			} else {
+				// vertices count from 1
+				if(format == TGMETIS) s += base[k] + 1;
+				if(s == 0 || t == 0 || s > n || t > n) {
+					fprintf(stderr, "Error: %s refers to vertex %"STR(FINT)", but there are only %"STR(FINT)" vertices.\n", infile, (s == 0 || s > n) ? s : t, n);
+					exit(-1);
+				}
+				s--;
+				t--;
+			}
+			chunks[k].e[i] = s;
+			chunks[k].e[i+1] = t;
+			C.off[s+2]++;
+		}
+	}
+	for(i=2; i<n+2; i++)
+		C.off[i] += C.off[i-1];
+	for(k=0; k<nt; k++) {
+		for(i=0; i<chunks[k].nume; i += 2)
+			C.adj[ C.off[chunks[k].e[i] + 1]++ ] = chunks[k].e[i+1];
+		free(chunks[k].e);
+	}
+
+	G = csr2graph(&C);
+
+	/* root vertices */
+	for(k=0; R != NULL && k<R->num; k++) {
+		p = tgnumber(R->id[k], R->id[k] + strlen(R->id[k]), &root);
+		if(p != NULL && format == TGEDGELIST) {
+			if(idmap != NULL) {
+				root = (root < numid) ? idmap[root] : NOVERTEX;
+			} else {
+				hit = (INT *) bsearch(&root, ids, n, sizeof(INT), &tgcompare);
+				root = (hit != NULL) ? (INT) (hit - ids) : NOVERTEX;
+			}
+		} else if(p != NULL) {
+			root = (root > 0) ? root - 1 : NOVERTEX;
+		}
+		if(p == NULL || root == NOVERTEX || root >= n) {
+			fprintf(stderr, "Error: could not find specified root vertex id in input file.\n");
+			exit(-1);
+		}
+		R->v[k] = G->arr[root];
+	}
+	if(R != NULL) G->root = R->v[0];
+
+	free(C.off);
+	free(C.adj);
+	free(chunks);
+	free(th);
+	free(base);
+	if(idmap != NULL) free(idmap);
+	if(ids != NULL) free(ids);
+	unmapinput(map, len, mapped);
+
+	return G;
+}
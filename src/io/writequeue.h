@@ -0,0 +1,304 @@
+/*
+ * Asynchronous output of samples
+ *
+ * When many samples are simulated (-N), the outputs of a sample are
+ * collected in a batch and handed to a writer thread, so the simulation of
+ * the next sample starts while the files of the previous one are written.
+ * The batches are written one after the other in the order in which they
+ * were queued, hence aggregated output files look exactly like before.
+ *
+ * At most depth batches wait in the queue, and further batches are only
+ * accepted while the estimated memory of the waiting batches stays below
+ * maxmem (a single batch is always accepted). With depth 0 every batch is
+ * written immediately by the calling thread.
+ *
+ * Usage:
+ *		startwriter(&Q, depth, maxmem);
+ *		B = newbatch(degprofile);			// degprofile belongs to B now
+ *		batchgraph(B, G);					// and G
+ *		additem(B, OUT_DEGSEQ, name, G, NULL, 0, 0, 0);
+ *		...
+ *		pushbatch(&Q, B);
+ *		stopwriter(&Q);
+ */
+
+
+#define OUT_PROFILE 1		// data: degree profile of length size
+#define OUT_MDEG 2			// data: degree profile of length size
+#define OUT_GRAPH 3			// graph G, freed after writing if format != 0
+#define OUT_DEGSEQ 4		// graph G
+#define OUT_HEIGHTSEQ 5		// graph G
+#define OUT_CENT 6			// graph G, vertices first, ..., size-1
+#define OUT_SEQ 7			// data: sequence of length size with format
+#define OUT_DIAMETER 8		// dm
+#define OUT_DISTANCES 9		// data: distance distribution, size entries
+#define OUT_WIENER 10		// wiener, size vertices
+#define OUT_MDEGGRAPH 11	// graph G
+#define OUT_LOOPTREE 12		// tree G, data: heights or NULL, freed after
+							// writing if format != 0
+#define OUT_WIDTH 13		// data: width profile with size heights
+#define OUT_PATH 14			// data: decimated path
+
+// every output file adds at most one item to the batch of a sample
+#define OUTMAXITEMS 18
+_Static_assert(OUTMAXITEMS >= OUTNUMFILES, "OUTMAXITEMS is smaller than the number of output files");
+
+
+// one output file of a sample
+struct outitem {
+	int type;
+	char *name;				// output file name, freed after writing
+	struct graph *G;
+	void *data;				// freed after writing (not for OUT_PROFILE
+							// and OUT_MDEG)
+	INT size;
+	int format;				// format of outseq(), for OUT_GRAPH nonzero if
+							// the graph belongs to the item
+	struct diam dm;
+	INTW wiener;
+	int attr;				// vertex attributes of OUT_GRAPH
+	INT first;				// first vertex of OUT_CENT
+};
+
+// all outputs of one sample
+struct outbatch {
+	struct outitem item[OUTMAXITEMS];
+	int num;
+	struct graph *G;		// freed after all items are written
+	INT *degprofile;		// freed after all items are written
+	size_t mem;				// estimated memory
+	struct outbatch *next;
+};
+
+struct outqueue {
+	struct outbatch *head;
+	struct outbatch *tail;
+	INT num;				// number of waiting batches
+	size_t mem;				// memory of the waiting batches
+	INT depth;
+	size_t maxmem;
+	int done;				// no more batches will be queued
+	pthread_t th;
+	pthread_mutex_t mut;
+	pthread_cond_t avail;	// a batch was queued
+	pthread_cond_t space;	// a batch was written
+};
+
+
+// estimated memory of a graph
+size_t graphmem(struct graph *G) {
+	size_t m;
+	INT i;
+	struct list *li;
+
+	if(G == NULL) return 0;
+
+	m = G->num * (sizeof(struct vertex) + sizeof(struct queue) + 3 * sizeof(struct vertex *));
+	for(i=0; i<G->num; i++) {
+		for(li = G->arr[i]->qu->li; li != NULL; li = li->ne)
+			m += sizeof(struct list);
+	}
+
+	return m;
+}
+
+
+struct outbatch *newbatch(INT *degprofile) {
+	struct outbatch *B;
+
+	B = (struct outbatch *) calloc(1, sizeof(struct outbatch));
+	if(B == NULL) {
+		fprintf(stderr, "Memory allocation error in function newbatch.\n");
+		exit(-1);
+	}
+	B->degprofile = degprofile;
+
+	return B;
+}
+
+
+// the graph G is freed after the batch has been written
+void batchgraph(struct outbatch *B, struct graph *G) {
+	B->G = G;
+	B->mem += graphmem(G);
+}
+
+
+// adds an output to the batch and returns it, the caller may set dm,
+// wiener and attr afterwards; datasize is the number of bytes of data
+struct outitem *additem(struct outbatch *B, int type, char *name, struct graph *G, void *data, INT size, int format, size_t datasize) {
+	struct outitem *it;
+
+	if(B->num == OUTMAXITEMS) {
+		fprintf(stderr, "Error: too many outputs in function additem.\n");
+		exit(-1);
+	}
+	it = &B->item[B->num++];
+	it->type = type;
+	it->name = name;
+	it->G = G;
+	it->data = data;
+	it->size = size;
+	it->format = format;
+	it->attr = 0;
+	it->first = 0;
+	B->mem += datasize;
+	if(type == OUT_GRAPH && format != 0) B->mem += graphmem(G);
+
+	return it;
+}
+
+
+// writes all outputs of a batch and frees them
+void writebatch(struct outbatch *B) {
+	struct outitem *it;
+	int i;
+
+	for(i=0; i<B->num; i++) {
+		it = &B->item[i];
+		switch(it->type) {
+			case OUT_PROFILE:
+				outdegprofile((INT *) it->data, it->size, it->name);
+				break;
+			case OUT_MDEG:
+				outmdeg((INT *) it->data, it->size, it->name);
+				break;
+			case OUT_GRAPH:
+				outgraphattr(it->G, it->name, it->attr);
+				if(it->format != 0) free_graph(it->G);
+				break;
+			case OUT_DEGSEQ:
+				outdegseq(it->G, it->name);
+				break;
+			case OUT_HEIGHTSEQ:
+				outheightseq(it->G, it->name);
+				break;
+			case OUT_CENT:
+				outcent(it->G, it->name, it->first, it->size);
+				break;
+			case OUT_SEQ:
+				outseq(it->data, it->size, it->name, it->format);
+				free(it->data);
+				break;
+			case OUT_DIAMETER:
+				outdiameter(&it->dm, it->name);
+				break;
+			case OUT_DISTANCES:
+				outdistances((INTD *) it->data, it->size, it->name);
+				free(it->data);
+				break;
+			case OUT_WIENER:
+				outwiener(it->wiener, it->size, it->name);
+				break;
+			case OUT_MDEGGRAPH:
+				outmdeggraph(it->G, it->name);
+				break;
+			case OUT_LOOPTREE:
+				outlooptree(it->G, (INT *) it->data, it->name);
+				if(it->format != 0) free(it->data);
+				break;
+			case OUT_WIDTH:
+				outwidth((INT *) it->data, it->size, it->name);
+				free(it->data);
+				break;
+			case OUT_PATH:
+				outpath((struct path *) it->data, it->name);	// frees the path
+				break;
+		}
+		free(it->name);
+	}
+
+	if(B->G != NULL) free_graph(B->G);
+	if(B->degprofile != NULL) free(B->degprofile);
+}
+
+
+// writer thread: write batches until the queue is closed
+void *writerthread(void *arg) {
+	struct outqueue *Q = (struct outqueue *) arg;
+	struct outbatch *B;
+	size_t mem;
+
+	while(1) {
+		pthread_mutex_lock(&Q->mut);
+		while(Q->head == NULL && !Q->done)
+			pthread_cond_wait(&Q->avail, &Q->mut);
+		B = Q->head;
+		pthread_mutex_unlock(&Q->mut);
+		if(B == NULL) break;
+
+		// the batch stays in the queue (and counts against the limits)
+		// until it is written
+		mem = B->mem;
+		writebatch(B);
+
+		pthread_mutex_lock(&Q->mut);
+		Q->head = B->next;
+		if(Q->head == NULL) Q->tail = NULL;
+		Q->num--;
+		Q->mem -= mem;
+		pthread_cond_signal(&Q->space);
+		pthread_mutex_unlock(&Q->mut);
+		free(B);
+	}
+
+	return NULL;
+}
+
+
+void startwriter(struct outqueue *Q, INT depth, size_t maxmem) {
+	Q->head = NULL;
+	Q->tail = NULL;
+	Q->num = 0;
+	Q->mem = 0;
+	Q->depth = depth;
+	Q->maxmem = maxmem;
+	Q->done = 0;
+	if(depth == 0) return;
+
+	pthread_mutex_init(&Q->mut, NULL);
+	pthread_cond_init(&Q->avail, NULL);
+	pthread_cond_init(&Q->space, NULL);
+	if(pthread_create(&Q->th, NULL, &writerthread, Q)) {
+		fprintf(stderr, "Error launching writer thread\n");
+		exit(-1);
+	}
+}
+
+
+// queues a batch, waits while the queue is full
+void pushbatch(struct outqueue *Q, struct outbatch *B) {
+	if(Q->depth == 0) {
+		writebatch(B);
+		free(B);
+		return;
+	}
+
+	pthread_mutex_lock(&Q->mut);
+	while(Q->num > 0 && (Q->num >= Q->depth || Q->mem + B->mem > Q->maxmem))
+		pthread_cond_wait(&Q->space, &Q->mut);
+	B->next = NULL;
+	if(Q->tail != NULL) Q->tail->next = B;
+	else Q->head = B;
+	Q->tail = B;
+	Q->num++;
+	Q->mem += B->mem;
+	pthread_cond_signal(&Q->avail);
+	pthread_mutex_unlock(&Q->mut);
+}
+
+
+// waits until all batches are written
+void stopwriter(struct outqueue *Q) {
+	if(Q->depth == 0) return;
+
+	pthread_mutex_lock(&Q->mut);
+	Q->done = 1;
+	pthread_cond_signal(&Q->avail);
+	pthread_mutex_unlock(&Q->mut);
+
+	pthread_join(Q->th, NULL);
+	pthread_mutex_destroy(&Q->mut);
+	pthread_cond_destroy(&Q->avail);
+	pthread_cond_destroy(&Q->space);
+}
@@ -101,6 +101,46 @@ struct graph *deg2bfstree(INT *D, INT len) {
 }
 
 
+/*
+ * Width profile of the tree with outdegree sequence D in bfs order, the
+ * number of vertices at every height W[0], ..., W[*num-1], without building
+ * the tree: the vertices of a height are consecutive in D and their
+ * outdegrees add up to the width of the next height
+ */
+INT *deg2widths(INT *D, INT len, INT *num) {
+	INT *W, *tmp;
+	INT pos, end, next, size;
+
+	size = 64;
+	W = (INT *) malloc(size * sizeof(INT));
+	if(W == NULL) {
+		fprintf(stderr, "Memory allocation error in function deg2widths\n");
+		exit(-1);
+	}
+
+	*num = 0;
+	pos = 0;
+	next = (len > 0);	// the root
+	while(next > 0) {
+		if(*num == size) {
+			size *= 2;
+			tmp = (INT *) realloc(W, size * sizeof(INT));
+			if(tmp == NULL) {
+				fprintf(stderr, "Memory allocation error in function deg2widths\n");
+				exit(-1);
+			}
+			W = tmp;
+		}
+		W[(*num)++] = next;
+		end = pos + next;
+		for(next = 0; pos < end && pos < len; pos++)
+			next += D[pos];
+	}
+
+	return W;
+}
+
+
 
 /*
  * Compute tree from outdegree sequence - dfs order
@@ -132,10 +172,23 @@ int gwtree(struct cmdarg *comarg, gsl_rng **rgens) {
 	mpfr_t *xi;			// offspring law
 	DOUBLE *q;			// weights for bnb modell
 	INT *D;				// degree sequence
+	INT *ecc;			// eccentricities
+	DOUBLE *btw;		// betweenness centralities
+	INT *par;			// parents in the tree
+	INT *lhei;			// heights in the looptree
+	DOUBLE *lclo;		// closeness centralities in the looptree
+	INT *wid;			// width profile
+	INT numh;			// number of heights
+	struct path *P;		// decimated path
+	INTD *hist;			// distance distribution
 	unsigned int counter;
 	char *cname;
-	struct graph *G, *H;
+	struct graph *G;
 	INT i;
+	INT *ord;
+	struct outqueue Q;	// samples waiting for output
+	struct outbatch *B;	// outputs of the current sample
+	struct outitem *it;
 
 	// select offspring distribution
 	q = NULL;
@@ -173,6 +226,13 @@ int gwtree(struct cmdarg *comarg, gsl_rng **rgens) {
 		q = precq(xi, comarg->size);
 	}
 
+	if( comarg->Tcentrange || comarg->Tckptfile ) {
+		fprintf(stderr, "Error: --cent-range and --checkpoint require --inputfile.\n");
+		exit(-1);
+	}
+
+	startwriter(&Q, comarg->queuedepth, (size_t) comarg->queuemem << 20);
+
 	for(counter=1; counter <= comarg->num; counter++) {	
 		/* simulate balls in boxes model */
 		if( comarg->Tpoisson ) {
@@ -181,87 +241,169 @@ int gwtree(struct cmdarg *comarg, gsl_rng **rgens) {
 			degprofile = tbinb(comarg->size, comarg->size-1, q, comarg->threads, rgens);
 		}
 
+		// the outputs are written after the calculations, the batch frees
+		// the degree profile and the tree afterwards
+		B = newbatch(degprofile);
+
 		/* output vertex outdegree profile if requested */
 		if( comarg->Tprofile ) {
 			cname = convname(comarg->profile, counter, comarg->num, comarg->Tnum);
-			outdegprofile(degprofile, comarg->size, cname);
-			free(cname);
+			additem(B, OUT_PROFILE, cname, NULL, degprofile, comarg->size, 0, 0);
 		}
 
 		/* output maximal degree if requested */
 		if( comarg->Tmdegfile ) {
 			cname = convname(comarg->mdegfile, counter, comarg->num, comarg->Tnum);
-			outmdeg(degprofile, comarg->size, cname);
-			free(cname);
+			additem(B, OUT_MDEG, cname, NULL, degprofile, comarg->size, 0, 0);
 		}
 
 		/* calculate degree sequence if necessary */
-		if( comarg->Tdegfile || comarg->Toutfile || comarg->Tloopfile || comarg->Theightfile || comarg->Tcentfile ) {
+		if( comarg->Twidthfile || comarg->Tlukafile || comarg->Thprocfile || comarg->Tcontourfile || comarg->Tdegfile || comarg->Toutfile || comarg->Tloopfile || comarg->Tloopheightfile || comarg->Tloopcentfile || comarg->Theightfile || comarg->Tcentfile || comarg->Tbetweenfile || comarg->Teccfile || comarg->Tdiamfile || comarg->Tdistfile || comarg->Twienerfile ) {
 
 			/* generate degree sequence with a fresh seed*/
 			D = gendegsequence(degprofile, comarg->size, rgens[0]);
 			/* cyclically shift sequence */
 			cycshift(D, comarg->size);
 
+			/* output width profile if requested */
+			// D is the degree sequence in bfs order, the tree is not needed
+			if( comarg->Twidthfile ) {
+				cname = convname(comarg->widthfile, counter, comarg->num, comarg->Tnum);
+				wid = deg2widths(D, comarg->size, &numh);
+				additem(B, OUT_WIDTH, cname, NULL, wid, numh, 0, numh * sizeof(INT));
+			}
+
+			/* output decimated Lukasiewicz path if requested */
+			if( comarg->Tlukafile ) {
+				cname = convname(comarg->lukafile, counter, comarg->num, comarg->Tnum);
+				P = lukapath(D, comarg->size, comarg->resolution);
+				additem(B, OUT_PATH, cname, NULL, P, 0, 0, 2 * P->num * sizeof(long long));
+			}
 
 			/* calculate graph if necessary */
-			if( comarg->Tdegfile || comarg->Toutfile || comarg->Tloopfile || comarg->Theightfile || comarg->Tcentfile ) {
+			if( comarg->Thprocfile || comarg->Tcontourfile || comarg->Tdegfile || comarg->Toutfile || comarg->Tloopfile || comarg->Tloopheightfile || comarg->Tloopcentfile || comarg->Theightfile || comarg->Tcentfile || comarg->Tbetweenfile || comarg->Teccfile || comarg->Tdiamfile || comarg->Tdistfile || comarg->Twienerfile ) {
 
 				// already sets the height deg attribute of each vertex
 				// list of vertices is now in dfs order, bfs order is set
 				G = deg2dfstree(D, comarg->size);
+				batchgraph(B, G);
 
 
 				/* output tree if requested */
 				if( comarg->Toutfile ) {
 					cname = convname(comarg->outfile, counter, comarg->num, comarg->Tnum);
-					outgraph(G,cname);
-					free(cname);
+					it = additem(B, OUT_GRAPH, cname, G, NULL, 0, 0, 0);
+					// the tree is written after the centralities are known
+					if( comarg->Tattributes )
+						it->attr = GATTR_DEG | GATTR_HEIGHT | GATTR_PARENT | (comarg->Tcentfile ? GATTR_CENT : 0);
 				}
 			
-				/* calculate and output looptree if requested */	
+				/* output looptree if requested */
+				// written directly from the tree, whose heights are set
 				if( comarg->Tloopfile ) {
 					cname = convname(comarg->loopfile, counter, comarg->num, comarg->Tnum);
-					H = looptree(G, G->arr[0]);
-					outgraph(H, cname);
-					free_graph(H);
-					free(cname);
+					additem(B, OUT_LOOPTREE, cname, G, NULL, 0, 0, 0);
 				}
 
+				/* looptree heights and closeness centrality if requested */
+				// computed from the tree, the vertices are in dfs order
+				if( comarg->Tloopheightfile || comarg->Tloopcentfile ) {
+					par = treeparents(G, G->arr);
+					if( comarg->Tloopheightfile ) {
+						cname = convname(comarg->loopheightfile, counter, comarg->num, comarg->Tnum);
+						lhei = loopheights(G, G->arr, par);
+						additem(B, OUT_SEQ, cname, NULL, lhei, G->num, 1, G->num * sizeof(INT));
+					}
+					if( comarg->Tloopcentfile ) {
+						cname = convname(comarg->loopcentfile, counter, comarg->num, comarg->Tnum);
+						lclo = loopcloseness(G, G->arr, par);
+						additem(B, OUT_SEQ, cname, NULL, lclo, G->num, 3, G->num * sizeof(DOUBLE));
+					}
+					free(par);
+				}
+
+
+				/* output decimated height and contour process if requested */
+				// the vertices are in dfs order
+				if( comarg->Thprocfile ) {
+					cname = convname(comarg->hprocfile, counter, comarg->num, comarg->Tnum);
+					P = heightpath(G->arr, NULL, G->num, comarg->resolution);
+					additem(B, OUT_PATH, cname, NULL, P, 0, 0, 2 * P->num * sizeof(long long));
+				}
+				if( comarg->Tcontourfile ) {
+					cname = convname(comarg->contourfile, counter, comarg->num, comarg->Tnum);
+					P = contourpath(G->arr, NULL, G->num, comarg->resolution);
+					additem(B, OUT_PATH, cname, NULL, P, 0, 0, 2 * P->num * sizeof(long long));
+				}
 
 				/* output degree sequence if requested */
 				if( comarg->Tdegfile ) {
 					cname = convname(comarg->degfile, counter, comarg->num, comarg->Tnum);
-					outdegseq(G, cname);
-					free(cname);
+					additem(B, OUT_DEGSEQ, cname, G, NULL, 0, 0, 0);
 				}
 				
 				/* output height sequence if requested */
 				if( comarg->Theightfile ) {
 					cname = convname(comarg->heightfile, counter, comarg->num, comarg->Tnum);
-					outheightseq(G, cname);
-					free(cname);
+					additem(B, OUT_HEIGHTSEQ, cname, G, NULL, 0, 0, 0);
 				}
 
 				/* Calculate closeness centrality if requested */
 				if( comarg->Tcentfile ) {
 					cname = convname(comarg->centfile, counter, comarg->num, comarg->Tnum);
-					threadedcentrality(G, 0, G->num, comarg->threads);
-					outcent(G, cname);
-					free(cname);
+					ord = reordergraph(G, G->root, comarg->reorder);
+					threadedcentrality(G, 0, G->num, comarg->threads, NULL, NULL);
+					undoreorder(G, ord);
+					additem(B, OUT_CENT, cname, G, NULL, G->num, 0, 0);
+				}
+
+				/* Calculate betweenness centrality if requested */
+				if( comarg->Tbetweenfile ) {
+					cname = convname(comarg->betweenfile, counter, comarg->num, comarg->Tnum);
+					btw = treebetweenness(G, G->arr);
+					additem(B, OUT_SEQ, cname, NULL, btw, G->num, 3, G->num * sizeof(DOUBLE));
 				}
 
-				// clean up
-				free_graph(G);
+				/* Calculate eccentricities if requested */
+				if( comarg->Teccfile ) {
+					cname = convname(comarg->eccfile, counter, comarg->num, comarg->Tnum);
+					ecc = treeeccentricity(G, G->root);
+					additem(B, OUT_SEQ, cname, NULL, ecc, G->num, 1, G->num * sizeof(INT));
+				}
+
+				/* Calculate diameter, radius and center if requested */
+				if( comarg->Tdiamfile ) {
+					cname = convname(comarg->diamfile, counter, comarg->num, comarg->Tnum);
+					it = additem(B, OUT_DIAMETER, cname, NULL, NULL, 0, 0, 0);
+					treediameter(G, G->root, &it->dm);
+				}
+
+				/* Calculate distance distribution if requested */
+				if( comarg->Tdistfile ) {
+					cname = convname(comarg->distfile, counter, comarg->num, comarg->Tnum);
+					hist = treedistances(G);
+					additem(B, OUT_DISTANCES, cname, NULL, hist, G->num, 0, G->num * sizeof(INTD));
+				}
+
+				/* Calculate Wiener index if requested */
+				if( comarg->Twienerfile ) {
+					cname = convname(comarg->wienerfile, counter, comarg->num, comarg->Tnum);
+					it = additem(B, OUT_WIENER, cname, NULL, NULL, G->num, 0, 0);
+					it->wiener = treewiener(G, G->arr);
+				}
 			}
 
 			// clean up
 			free(D);
 		}
-		// clean up
-		free(degprofile);
+
+		// hand the outputs to the writer thread
+		pushbatch(&Q, B);
 	}
 
+	// wait for the remaining outputs
+	stopwriter(&Q);
+
 	// clean up offspring distribution
 	if(xi != NULL) {
 		for(i=0; i<comarg->size; i++)